@@ -19,6 +19,9 @@
 //    GNU General Public License for more details.                          //
 /****************************************************************************/
 
+#include <algorithm>
+#include <filesystem>
+
 #include "audio/openpsf/openpsf.h"
 
 #include "audio.h"
@@ -69,41 +72,133 @@ void NxAudioEngine::loadConfig()
 			break;
 		}
 
+		_trackConfigs[type].clear();
+
 		try
 		{
-			nxAudioEngineConfig[type] = toml::parse_file(_fullpath);
+			compileConfig(type, toml::parse_file(_fullpath));
 		}
 		catch (const toml::parse_error &err)
 		{
 			ffnx_warning("Parse error while opening the file %s. Will continue with the default settings.\n", _fullpath);
 			ffnx_warning("%s (Line %u Column %u)\n", err.what(), err.source().begin.line, err.source().begin.column);
-
-			nxAudioEngineConfig[type] = toml::parse("");
 		}
 	}
 }
 
-bool NxAudioEngine::getFilenameFullPath(char *_out, const char* _key, NxAudioEngineLayer _type)
+void NxAudioEngine::compileConfig(NxAudioEngineLayer type, const toml::table& config)
 {
-	std::vector<std::string> extensions;
+	// SFX ids are integers, every other layer refers to other tracks by name
+	compileTrackConfigs(_trackConfigs[type], config, type == NxAudioEngineLayer::NXAUDIOENGINE_SFX, type == NxAudioEngineLayer::NXAUDIOENGINE_VOICE);
+
+	if (trace_all) ffnx_trace("NxAudioEngine::%s: %u tracks configured for layer %d\n", __func__, _trackConfigs[type].size(), type);
+}
 
+const NxAudioEngineTrackConfig* NxAudioEngine::getTrackConfig(NxAudioEngineLayer type, const std::string& name)
+{
+	auto it = _trackConfigs[type].find(name);
+
+	return it != _trackConfigs[type].end() ? &it->second : nullptr;
+}
+
+std::string NxAudioEngine::getFileIndexKey(const std::string& key)
+{
+	std::string ret;
+
+	ret.reserve(key.size());
+
+	for (char c : key)
+	{
+		if (c == '\\') c = '/';
+
+		ret.push_back(::tolower((unsigned char)c));
+	}
+
+	return ret;
+}
+
+const std::vector<std::string>& NxAudioEngine::getLayerExtensions(NxAudioEngineLayer _type)
+{
 	switch(_type)
 	{
 		case NxAudioEngineLayer::NXAUDIOENGINE_SFX:
-			extensions = external_sfx_ext;
-			break;
+			return external_sfx_ext;
 		case NxAudioEngineLayer::NXAUDIOENGINE_MUSIC:
-			extensions = external_music_ext;
-			break;
+			return external_music_ext;
 		case NxAudioEngineLayer::NXAUDIOENGINE_VOICE:
-			extensions = external_voice_ext;
-			break;
+			return external_voice_ext;
 		case NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT:
-			extensions = external_ambient_ext;
-			break;
-		case NxAudioEngineLayer::NXAUDIOENGINE_MOVIE_AUDIO:
-			extensions = external_movie_audio_ext;
-			break;
+			return external_ambient_ext;
+		default:
+			return external_movie_audio_ext;
+	}
+}
+
+void NxAudioEngine::indexLayer(NxAudioEngineLayer _type, const std::string& dir)
+{
+	const std::vector<std::string>& extensions = getLayerExtensions(_type);
+	std::unordered_map<std::string, std::string>& index = _fileIndexes[_type];
+	// Position in the extensions list of every indexed file, the first configured extension wins like when probing
+	std::unordered_map<std::string, size_t> priorities;
+	std::error_code ec;
+
+	index.clear();
+
+	for (auto it = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+	{
+		std::string relativePath;
+
+		// Names the game can't request are skipped, path::string() would throw on them
+		if (!it->is_regular_file(ec) || !pathToAnsi(it->path().lexically_relative(dir), relativePath)) continue;
+
+		std::filesystem::path relative(relativePath);
+		std::string extension = relative.extension().string();
+
+		if (extension.empty()) continue;
+
+		extension = getFileIndexKey(extension.substr(1));
+
+		auto priority = std::find_if(extensions.begin(), extensions.end(), [&extension](const std::string& ext) { return _stricmp(ext.c_str(), extension.c_str()) == 0; });
+
+		if (priority == extensions.end()) continue;
+
+		std::string key = getFileIndexKey(relative.replace_extension().string());
+		size_t position = priority - extensions.begin();
+		auto current = priorities.find(key);
+
+		if (current != priorities.end() && current->second <= position) continue;
+
+		priorities[key] = position;
+		index[key] = dir + "/" + relativePath;
+	}
+}
+
+bool NxAudioEngine::getFilenameFullPath(char *_out, const char* _key, NxAudioEngineLayer _type)
+{
+	const std::vector<std::string>& extensions = getLayerExtensions(_type);
+	auto index = _fileIndexes.find(_type);
+	bool indexed = index != _fileIndexes.end();
+
+	if (indexed)
+	{
+		auto file = index->second.find(getFileIndexKey(_key));
+
+		_fileIndexSavedCalls += extensions.size();
+
+		if (file != index->second.end())
+		{
+			strcpy(_out, file->second.c_str());
+
+			return true;
+		}
+
+		// Keep the key in the output, callers use it in their traces
+		snprintf(_out, MAX_PATH, "%s", _key);
+
+		if (trace_all || trace_music || trace_sfx || trace_voice || trace_ambient)
+			ffnx_warning("NxAudioEngine::%s: Could not find file %s\n", __func__, _out);
+
+		return false;
 	}
 
 	for (const std::string &extension: extensions) {
@@ -159,6 +254,10 @@ bool NxAudioEngine::init()
 
 		loadConfig();
 
+		indexFiles();
+
+		if (enable_voice_prefetch) startVoicePrefetch();
+
 		if (!he_bios_path.empty()) {
 			char fullHeBiosPath[MAX_PATH];
 			sprintf(fullHeBiosPath, "%s/%s", basedir, he_bios_path.c_str());
@@ -210,52 +309,233 @@ void NxAudioEngine::flush()
 	_currentStream = NxAudioEngineStreamAudio();
 }
 
+void NxAudioEngine::indexFiles()
+{
+	if (!enable_audio_file_index) return;
+
+	auto startTime = highResolutionNow();
+	size_t count = 0;
+
+	_fileIndexes.clear();
+
+	for (int idx = NxAudioEngineLayer::NXAUDIOENGINE_SFX; idx <= NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT; idx++)
+	{
+		NxAudioEngineLayer type = NxAudioEngineLayer(idx);
+		char dir[MAX_PATH];
+
+		switch (type)
+		{
+		case NxAudioEngineLayer::NXAUDIOENGINE_SFX:
+			sprintf(dir, "%s/%s", basedir, external_sfx_path.c_str());
+			break;
+		case NxAudioEngineLayer::NXAUDIOENGINE_MUSIC:
+			sprintf(dir, "%s/%s", basedir, external_music_path.c_str());
+			break;
+		case NxAudioEngineLayer::NXAUDIOENGINE_VOICE:
+			sprintf(dir, "%s/%s", basedir, external_voice_path.c_str());
+			break;
+		case NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT:
+			sprintf(dir, "%s/%s", basedir, external_ambient_path.c_str());
+			break;
+		}
+
+		indexLayer(type, dir);
+
+		count += _fileIndexes[type].size();
+	}
+
+	// Movie audio files live next to the movies and keep being probed on disk
+	ffnx_info("NxAudioEngine::%s: indexed %u files (%.2lf ms)\n", __func__, uint32_t(count), elapsedMicroseconds(startTime) / 1000.0);
+}
+
+uint32_t NxAudioEngine::getFileIndexSavedCalls()
+{
+	return _fileIndexSavedCalls;
+}
+
 void NxAudioEngine::cleanup()
 {
 	_engine.deinit();
+
+	for (NxAudioEngineSFXCacheEntry& entry : _sfxCache) delete entry.wav;
+
+	_sfxCache.clear();
+	_sfxCacheIndex.clear();
+	_sfxCacheSize = 0;
 }
 
 // SFX
-SoLoud::VGMStream* NxAudioEngine::loadSFX(std::string id, bool loop)
+SoLoud::VGMStream* NxAudioEngine::openSFX(const std::string& id, bool loop)
 {
-	if (_engineInitialized)
+	char filename[MAX_PATH];
+
+	bool exists = getFilenameFullPath(filename, id.c_str(), NxAudioEngineLayer::NXAUDIOENGINE_SFX);
+
+	if (exists)
 	{
-		char filename[MAX_PATH];
+		if (trace_all || trace_sfx) ffnx_trace("NxAudioEngine::%s: filename=%s,loop=%d\n", __func__, filename, loop);
 
-		bool exists = getFilenameFullPath(filename, id.c_str(), NxAudioEngineLayer::NXAUDIOENGINE_SFX);
+		SoLoud::VGMStream* sfx = new SoLoud::VGMStream();
 
-		if (exists)
-		{
-			auto node = nxAudioEngineConfig[NxAudioEngineLayer::NXAUDIOENGINE_SFX][id];
+		sfx->setLooping(loop);
 
-			if (node)
-			{
-				int shouldLoop = node["loop"].value_or(-1);
+		SoLoud::result res = sfx->load(filename);
+		if (res != SoLoud::SO_NO_ERROR) {
+			ffnx_error("NxAudioEngine::%s: Cannot load %s with vgmstream ( SoLoud error: %u )\n", __func__, filename, res);
+			delete sfx;
+			return nullptr;
+		}
 
-				// Force loop if requested in the config
-				if (shouldLoop != -1) loop = shouldLoop;
-			}
+		return sfx;
+	}
 
-			if (trace_all || trace_sfx) ffnx_trace("NxAudioEngine::%s: filename=%s,loop=%d\n", __func__, filename, loop);
+	return nullptr;
+}
+
+SoLoud::AudioSource* NxAudioEngine::loadSFX(std::string id, bool loop, bool cacheable)
+{
+	if (_engineInitialized)
+	{
+		const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_SFX, id);
 
-			SoLoud::VGMStream* sfx = new SoLoud::VGMStream();
+		// Force loop if requested in the config
+		if (track && track->loop != -1) loop = track->loop;
 
-			sfx->setLooping(loop);
+		// Looping effects are usually long, keep streaming them
+		if (!cacheable || loop || external_sfx_cache_size <= 0) return openSFX(id, loop);
 
-			SoLoud::result res = sfx->load(filename);
-			if (res != SoLoud::SO_NO_ERROR) {
-				ffnx_error("NxAudioEngine::%s: Cannot load %s with vgmstream ( SoLoud error: %u )\n", __func__, filename, res);
-				delete sfx;
-				return nullptr;
-			}
+		auto startTime = highResolutionNow();
+		SoLoud::AudioSource* sfx = getCachedSFX(id);
+
+		if (sfx != nullptr)
+		{
+			_sfxCacheHits++;
+			_sfxCacheHitTime += uint64_t(elapsedMicroseconds(startTime));
 
 			return sfx;
 		}
+
+		SoLoud::VGMStream* stream = openSFX(id, loop);
+
+		if (stream != nullptr)
+		{
+			sfx = cacheSFX(id, stream);
+
+			if (sfx != nullptr) delete stream;
+			else sfx = stream;
+
+			_sfxCacheMisses++;
+			_sfxCacheMissTime += uint64_t(elapsedMicroseconds(startTime));
+		}
+
+		return sfx;
 	}
 
 	return nullptr;
 }
 
+SoLoud::Wav* NxAudioEngine::getCachedSFX(const std::string& id)
+{
+	auto it = _sfxCacheIndex.find(id);
+
+	if (it == _sfxCacheIndex.end()) return nullptr;
+
+	_sfxCache.splice(_sfxCache.begin(), _sfxCache, it->second);
+
+	return it->second->wav;
+}
+
+SoLoud::Wav* NxAudioEngine::cacheSFX(const std::string& id, SoLoud::VGMStream* stream)
+{
+	VGMSTREAM* vgmstream = stream->mStream;
+
+	// Files can loop on their own, even if the game did not ask for it
+	if (vgmstream->loop_flag || stream->getLength() > NXAUDIOENGINE_SFX_CACHE_MAX_LENGTH) return nullptr;
+
+	const size_t maxSize = size_t(external_sfx_cache_size) * 1024 * 1024;
+	const unsigned int channels = stream->mChannels, sampleCount = stream->mSampleCount;
+	const size_t size = size_t(sampleCount) * channels * sizeof(float);
+
+	if (sampleCount == 0 || size > maxSize) return nullptr;
+
+	// Evict the least recently used effects, but never one which is still referenced by a channel
+	auto it = _sfxCache.end();
+
+	while (_sfxCacheSize + size > maxSize && it != _sfxCache.begin())
+	{
+		--it;
+
+		if (isSFXInUse(it->wav)) continue;
+
+		_sfxCacheSize -= it->size;
+		_sfxCacheIndex.erase(it->id);
+		delete it->wav;
+		it = _sfxCache.erase(it);
+	}
+
+	if (_sfxCacheSize + size > maxSize) return nullptr;
+
+	// SoLoud::Wav keeps one plane per channel
+	float* data = new float[size_t(sampleCount) * channels];
+	sample_t buffer[SAMPLE_GRANULARITY * 2 * 8];
+	const unsigned int bufferSamples = sizeof(buffer) / sizeof(sample_t) / channels;
+	unsigned int offset = 0;
+
+	while (offset < sampleCount)
+	{
+		int count = render_vgmstream2(buffer, std::min(bufferSamples, sampleCount - offset), vgmstream);
+
+		if (count <= 0) break;
+
+		SoLoud::deinterleave_s16(data + offset, buffer, count, channels, sampleCount);
+
+		offset += count;
+	}
+
+	// Pad anything the decoder could not provide with silence
+	for (unsigned int k = 0; k < channels && offset < sampleCount; k++) memset(&data[k * sampleCount + offset], 0, (sampleCount - offset) * sizeof(float));
+
+	SoLoud::Wav* wav = new SoLoud::Wav();
+
+	if (wav->loadRawWave(data, sampleCount * channels, stream->mBaseSamplerate, channels, false, true) != SoLoud::SO_NO_ERROR)
+	{
+		delete[] data;
+		delete wav;
+
+		return nullptr;
+	}
+
+	_sfxCache.push_front({ id, wav, size });
+	_sfxCacheIndex[id] = _sfxCache.begin();
+	_sfxCacheSize += size;
+
+	if (trace_all || trace_sfx) ffnx_trace("NxAudioEngine::%s: id=%s,size=%u,cache_size=%u\n", __func__, id.c_str(), size, _sfxCacheSize);
+
+	return wav;
+}
+
+bool NxAudioEngine::isSFXCached(SoLoud::AudioSource* stream)
+{
+	return std::any_of(_sfxCache.begin(), _sfxCache.end(), [stream](const NxAudioEngineSFXCacheEntry& entry) { return entry.wav == stream; });
+}
+
+bool NxAudioEngine::isSFXInUse(SoLoud::AudioSource* stream)
+{
+	if (_engine.countAudioSource(*stream) > 0) return true;
+
+	for (const auto& [channel, options] : _sfxChannels)
+	{
+		if (options.stream == stream) return true;
+	}
+
+	for (const auto& [id, handler] : _sfxEffectsHandler)
+	{
+		if (handler == stream) return true;
+	}
+
+	return false;
+}
+
 int NxAudioEngine::getSFXIdFromChannel(int channel)
 {
 	return _sfxChannels[channel].game_id;
@@ -267,7 +547,7 @@ void NxAudioEngine::unloadSFX(int id)
 	{
 		if (_sfxEffectsHandler[id] != nullptr)
 		{
-			delete _sfxEffectsHandler[id];
+			if (!isSFXCached(_sfxEffectsHandler[id])) delete _sfxEffectsHandler[id];
 
 			_sfxEffectsHandler.erase(id);
 		}
@@ -282,7 +562,9 @@ void NxAudioEngine::unloadSFXChannel(int channel)
 
 	if (options->stream != nullptr)
 	{
-		delete options->stream;
+		// Cached effects are shared, only stop what this channel was playing
+		if (isSFXCached(options->stream)) _engine.stop(options->handle);
+		else delete options->stream;
 
 		options->stream = nullptr;
 	}
@@ -293,6 +575,7 @@ bool NxAudioEngine::playSFX(const char* name, int id, int channel, float panning
 	NxAudioEngineSFX *options = &_sfxChannels[channel - 1];
 	int _curId = id;
 	bool skipPlay = false;
+	bool lazyUnload = std::find(_sfxLazyUnloadChannels.begin(), _sfxLazyUnloadChannels.end(), channel) != _sfxLazyUnloadChannels.end();
 	std::string _id(name);
 
 	// If channel is known to be reusable
@@ -312,7 +595,7 @@ bool NxAudioEngine::playSFX(const char* name, int id, int channel, float panning
 		}
 	}
 	// If channel is known to lazy unload what is currently playing, save the handler for later
-	else if (std::find(_sfxLazyUnloadChannels.begin(), _sfxLazyUnloadChannels.end(), channel) != _sfxLazyUnloadChannels.end())
+	else if (lazyUnload)
 	{
 		_sfxEffectsHandler[options->game_id] = options->stream;
 
@@ -328,38 +611,34 @@ bool NxAudioEngine::playSFX(const char* name, int id, int channel, float panning
 	// Reset state
 	options->volume = volume;
 
-	auto node = nxAudioEngineConfig[NxAudioEngineLayer::NXAUDIOENGINE_SFX][name];
-	if (node)
+	const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_SFX, name);
+	if (track)
 	{
 		// Shuffle SFX playback, if any entry found for the current id
-		toml::array *shuffleIds = node["shuffle"].as_array();
-		if (shuffleIds && !shuffleIds->empty() && shuffleIds->is_homogeneous(toml::node_type::integer))
+		if (!track->shuffleIds.empty())
 		{
-			auto _newId = shuffleIds->get(getRandomInt(0, shuffleIds->size() - 1));
-
-			_curId = _newId->value_or(id);
+			_curId = track->shuffleIds[getRandomInt(0, track->shuffleIds.size() - 1)];
 			_id = std::to_string(_curId);
 		}
 
 		// Sequentially playback new SFX ids, if any entry found for the current id
-		toml::array *sequentialIds = node["sequential"].as_array();
-		if (sequentialIds && !sequentialIds->empty() && sequentialIds->is_homogeneous(toml::node_type::integer))
+		if (!track->sequentialIds.empty())
 		{
-			if (_sfxSequentialIndexes.find(name) == _sfxSequentialIndexes.end() || _sfxSequentialIndexes[name] >= sequentialIds->size())
-				_sfxSequentialIndexes[name] = 0;
+			int& sequentialIndex = _sfxSequentialIndexes[name];
 
-			auto _newId = sequentialIds->get(_sfxSequentialIndexes[name]);
+			if (sequentialIndex >= track->sequentialIds.size())
+				sequentialIndex = 0;
 
-			_sfxSequentialIndexes[name]++;
+			_curId = track->sequentialIds[sequentialIndex];
+
+			sequentialIndex++;
 
-			_curId = _newId->value_or(id);
 			_id = std::to_string(_curId);
 		}
 
 		// Should we skip playing the track?
-		toml::node *shouldSkip = node["skip"].as_boolean();
-		if (shouldSkip && shouldSkip->is_boolean()) {
-			skipPlay = shouldSkip->value_or(false);
+		if (track->skip != -1) {
+			skipPlay = track->skip;
 		}
 	}
 
@@ -369,7 +648,8 @@ bool NxAudioEngine::playSFX(const char* name, int id, int channel, float panning
 		options->game_id = id;
 		options->id = _curId;
 		// Avoid loading a stream if it is meant to be skipped
-		options->stream = skipPlay ? nullptr : loadSFX(_id, loop);
+		// Lazy unloaded channels outlive the channel, so they keep their own stream
+		options->stream = skipPlay ? nullptr : loadSFX(_id, loop, !lazyUnload);
 	}
 
 	if (skipPlay)
@@ -524,6 +804,60 @@ void NxAudioEngine::addSFXLazyUnloadChannel(int channel)
 	_sfxLazyUnloadChannels.push_back(channel);
 }
 
+void NxAudioEngine::preloadSFX(const char* name)
+{
+	if (!_engineInitialized || external_sfx_cache_size <= 0) return;
+
+	const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_SFX, name);
+
+	if (!track || track->preloadIds.empty()) return;
+
+	auto startTime = highResolutionNow();
+
+	for (int preloadId : track->preloadIds)
+	{
+		std::string id = std::to_string(preloadId);
+
+		if (_sfxCacheIndex.contains(id)) continue;
+
+		// Only preload effects which would be cached when played
+		const NxAudioEngineTrackConfig* preloadTrack = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_SFX, id);
+
+		if (preloadTrack && preloadTrack->loop == 1) continue;
+
+		SoLoud::VGMStream* stream = openSFX(id, false);
+
+		if (stream != nullptr)
+		{
+			cacheSFX(id, stream);
+
+			delete stream;
+		}
+	}
+
+	if (trace_all || trace_sfx) ffnx_trace("NxAudioEngine::%s: name=%s,count=%u,time=%.2lf ms\n", __func__, name, preloadIds->size(), elapsedMicroseconds(startTime) / 1000.0);
+}
+
+uint32_t NxAudioEngine::getSFXCacheHits()
+{
+	return _sfxCacheHits;
+}
+
+uint32_t NxAudioEngine::getSFXCacheMisses()
+{
+	return _sfxCacheMisses;
+}
+
+double NxAudioEngine::getSFXCacheHitLatency()
+{
+	return _sfxCacheHits > 0 ? _sfxCacheHitTime / 1000.0 / _sfxCacheHits : 0.0;
+}
+
+double NxAudioEngine::getSFXCacheMissLatency()
+{
+	return _sfxCacheMisses > 0 ? _sfxCacheMissTime / 1000.0 / _sfxCacheMisses : 0.0;
+}
+
 // Music
 bool NxAudioEngine::canPlayMusic(const char* name)
 {
@@ -534,17 +868,16 @@ bool NxAudioEngine::canPlayMusic(const char* name)
 
 bool NxAudioEngine::isMusicDisabled(const char* name)
 {
-	char lowercaseName[MAX_PATH];
+	std::string lowercaseName(name);
 
 	// Name to lower case
-	for (int i = 0; name[i]; i++) {
-		lowercaseName[i] = tolower(name[i]);
+	for (char& c : lowercaseName) {
+		c = tolower(c);
 	}
 
-	toml::table config = nxAudioEngineConfig[NXAUDIOENGINE_MUSIC];
-	std::optional<bool> disabled = config[lowercaseName]["disabled"].value<bool>();
+	const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_MUSIC, lowercaseName);
 
-	return disabled.has_value() && disabled;
+	return track && track->disabled;
 }
 
 void NxAudioEngine::cleanOldAudioSources()
@@ -623,54 +956,57 @@ void NxAudioEngine::overloadPlayArgumentsFromConfig(char* name, uint32_t* id, Mu
 		name[i] = tolower(name[i]);
 	}
 
-	toml::table config = nxAudioEngineConfig[NXAUDIOENGINE_MUSIC];
-	std::optional<SoLoud::time> offset_seconds_opt = config[name]["offset_seconds"].value<SoLoud::time>();
-	std::optional<std::string> no_intro_track_opt = config[name]["no_intro_track"].value<std::string>();
-	std::optional<SoLoud::time> intro_seconds_opt = config[name]["intro_seconds"].value<SoLoud::time>();
-	std::optional<float> relative_speed_opt = config[name]["relative_speed"].value<float>();
+	const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_MUSIC, name);
 
-	if (offset_seconds_opt.has_value()) {
-		musicOptions->offsetSeconds = *offset_seconds_opt;
-	} else {
-		std::optional<std::string> offset_special_opt = config[name]["offset_seconds"].value<std::string>();
-
-		if (offset_special_opt.has_value() && offset_special_opt->compare("sync") == 0) {
-			musicOptions->sync = true;
+	if (track == nullptr) {
+		if (musicOptions->noIntro) {
+			ffnx_info("%s: cannot play no intro track, please configure it in %s/config.toml\n", __func__, external_music_path.c_str());
 		}
+
+		return;
+	}
+
+	if (track->offsetSeconds.has_value()) {
+		musicOptions->offsetSeconds = *track->offsetSeconds;
+	} else if (track->offsetSync) {
+		musicOptions->sync = true;
+	}
+
+	if (track->relativeSpeed.has_value() && *track->relativeSpeed > 0.0f) {
+		musicOptions->relativeSpeed = *track->relativeSpeed;
 	}
 
 	if (musicOptions->noIntro) {
-		if (no_intro_track_opt.has_value()) {
-			std::string no_intro_track = *no_intro_track_opt;
+		if (track->noIntroTrack.has_value()) {
+			const std::string& no_intro_track = *track->noIntroTrack;
 			if (trace_all || trace_music) ffnx_info("%s: replaced by no intro track %s\n", __func__, no_intro_track.c_str());
 
 			if (!no_intro_track.empty()) {
 				memcpy(name, no_intro_track.c_str(), no_intro_track.size());
 				name[no_intro_track.size()] = '\0';
+
+				// Shuffle options are looked up from the no intro track from now on
+				track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_MUSIC, name);
 			}
 		}
-		else if (intro_seconds_opt.has_value()) {
-			musicOptions->offsetSeconds = *intro_seconds_opt;
+		else if (track->introSeconds.has_value()) {
+			musicOptions->offsetSeconds = *track->introSeconds;
 		}
 		else {
 			ffnx_info("%s: cannot play no intro track, please configure it in %s/config.toml\n", __func__, external_music_path.c_str());
 		}
 	}
 
-	if (relative_speed_opt.has_value() && *relative_speed_opt > 0.0f) {
-		musicOptions->relativeSpeed = *relative_speed_opt;
-	}
+	if (track == nullptr) return;
 
 	// Shuffle Music playback, if any entry found for the current music name
-	toml::array* shuffleNames = config[name]["shuffle"].as_array();
-	if (shuffleNames && !shuffleNames->empty() && shuffleNames->is_homogeneous(toml::node_type::string)) {
-		std::optional<std::string> _newName = shuffleNames->get(getRandomInt(0, shuffleNames->size() - 1))->value<std::string>();
-		if (_newName.has_value()) {
-			memcpy(name, (*_newName).c_str(), (*_newName).size());
-			name[(*_newName).size()] = '\0';
-
-			if (trace_all || trace_music) ffnx_info("%s: replaced by shuffle with %s\n", __func__, (*_newName).c_str());
-		}
+	if (!track->shuffleNames.empty()) {
+		const std::string& _newName = track->shuffleNames[getRandomInt(0, track->shuffleNames.size() - 1)];
+
+		memcpy(name, _newName.c_str(), _newName.size());
+		name[_newName.size()] = '\0';
+
+		if (trace_all || trace_music) ffnx_info("%s: replaced by shuffle with %s\n", __func__, _newName.c_str());
 	}
 }
 
@@ -1065,46 +1401,44 @@ bool NxAudioEngine::playVoice(const char* name, int slot, float volume, int game
 	// TOML doesn't like the / char as key, replace it with - ( one of the valid accepted chars )
 	replaceAll(_name, '/', '-');
 
-	auto node = nxAudioEngineConfig[NxAudioEngineLayer::NXAUDIOENGINE_VOICE][_name];
+	const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_VOICE, _name);
 
   // Attempt to load a subnode based on the current game moment
-  if (game_moment > -1)
+  if (track && game_moment > -1)
   {
-    std::string _gamemoment("gm-" + std::to_string(game_moment));
-    auto subnode = node[_gamemoment];
-    if (subnode) node = subnode;
+    const NxAudioEngineTrackConfig* subtrack = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_VOICE, _name + "/gm-" + std::to_string(game_moment));
+    if (subtrack) track = subtrack;
   }
 
-	if (node)
+	if (track)
 	{
 		// Set volume for the current track
-		toml::node *trackVolume = node["volume"].as_integer();
-		if (trackVolume)
+		if (track->volume != -1)
 		{
-			_currentVoice[slot].volume = (trackVolume->value_or(100) / 100.0f) * getVoiceMasterVolume();
+			_currentVoice[slot].volume = (track->volume / 100.0f) * getVoiceMasterVolume();
 		}
 
 		// Shuffle Voice playback, if any entry found for the current id
-		toml::array *shuffleNames = node["shuffle"].as_array();
-		if (shuffleNames && !shuffleNames->empty() && shuffleNames->is_homogeneous(toml::node_type::string))
+		if (!track->shuffleNames.empty())
 		{
-			auto _newName = shuffleNames->get(getRandomInt(0, shuffleNames->size() - 1));
+			const std::string& _newName = track->shuffleNames[getRandomInt(0, track->shuffleNames.size() - 1)];
 
-			exists = getFilenameFullPath(filename, _newName->value_or(name), NxAudioEngineLayer::NXAUDIOENGINE_VOICE);
+			exists = getFilenameFullPath(filename, _newName.c_str(), NxAudioEngineLayer::NXAUDIOENGINE_VOICE);
 		}
 
 		// Sequentially playback new voice items, if any entry found for the current id
-		toml::array *sequentialNames = node["sequential"].as_array();
-		if (sequentialNames && !sequentialNames->empty() && sequentialNames->is_homogeneous(toml::node_type::string))
+		if (!track->sequentialNames.empty())
 		{
-			if (_voiceSequentialIndexes.find(name) == _voiceSequentialIndexes.end() || _voiceSequentialIndexes[name] >= sequentialNames->size())
-				_voiceSequentialIndexes[name] = 0;
+			int& sequentialIndex = _voiceSequentialIndexes[name];
 
-			auto _newName = sequentialNames->get(_voiceSequentialIndexes[name]);
+			if (sequentialIndex >= track->sequentialNames.size())
+				sequentialIndex = 0;
 
-			_voiceSequentialIndexes[name]++;
+			const std::string& _newName = track->sequentialNames[sequentialIndex];
 
-			exists = getFilenameFullPath(filename, _newName->value_or(name), NxAudioEngineLayer::NXAUDIOENGINE_VOICE);
+			sequentialIndex++;
+
+			exists = getFilenameFullPath(filename, _newName.c_str(), NxAudioEngineLayer::NXAUDIOENGINE_VOICE);
 		}
 	}
 
@@ -1127,13 +1461,19 @@ bool NxAudioEngine::playVoice(const char* name, int slot, float volume, int game
 			_currentVoice[slot].handle = NXAUDIOENGINE_INVALID_HANDLE;
 		}
 
-		_currentVoice[slot].stream = new SoLoud::VGMStream();
+		_currentVoice[slot].stream = takePrefetchedVoice(name, filename);
 
-		SoLoud::result res = _currentVoice[slot].stream->load(filename);
-		if (res != SoLoud::SO_NO_ERROR) {
-			ffnx_error("NxAudioEngine::%s: Cannot load %s with vgmstream ( SoLoud error: %u )\n", __func__, filename, res);
-			delete _currentVoice[slot].stream;
-			return false;
+		if (_currentVoice[slot].stream == nullptr)
+		{
+			_currentVoice[slot].stream = new SoLoud::VGMStream();
+
+			SoLoud::result res = _currentVoice[slot].stream->load(filename);
+			if (res != SoLoud::SO_NO_ERROR) {
+				ffnx_error("NxAudioEngine::%s: Cannot load %s with vgmstream ( SoLoud error: %u )\n", __func__, filename, res);
+				delete _currentVoice[slot].stream;
+				_currentVoice[slot].stream = nullptr;
+				return false;
+			}
 		}
 
 		_currentVoice[slot].handle = _engine.play(*_currentVoice[slot].stream, _currentVoice[slot].volume);
@@ -1203,6 +1543,203 @@ void NxAudioEngine::setVoiceMaxSlots(int slot)
 	_voiceMaxSlots = slot;
 }
 
+void NxAudioEngine::voicePrefetchWorker()
+{
+	std::unique_lock<std::mutex> lock(_voicePrefetchMutex);
+
+	while (true)
+	{
+		_voicePrefetchWork.wait(lock, [this] { return !_voicePrefetchRunning || !_voicePrefetchQueue.empty(); });
+
+		if (!_voicePrefetchRunning) break;
+
+		NxAudioEngineVoicePrefetch request = std::move(_voicePrefetchQueue.front());
+		_voicePrefetchQueue.pop_front();
+
+		lock.unlock();
+
+		char resolved[MAX_PATH];
+		bool found = resolvePrefetchedVoice(request, resolved);
+
+		lock.lock();
+
+		if (!_voicePrefetchRunning) break;
+
+		if (!found || _voicePrefetchReady.count(resolved) > 0) continue;
+
+		_voicePrefetchLoading = resolved;
+
+		std::string filename = _voicePrefetchLoading;
+
+		lock.unlock();
+
+		SoLoud::VGMStream* stream = new SoLoud::VGMStream();
+
+		if (stream->load(filename.c_str()) == SoLoud::SO_NO_ERROR)
+		{
+			// Decode the first block so the file header and the first frames are already in the OS cache
+			sample_t* buffer = new sample_t[SAMPLE_GRANULARITY * stream->mChannels];
+			render_vgmstream2(buffer, SAMPLE_GRANULARITY, stream->mStream);
+			reset_vgmstream(stream->mStream);
+			delete[] buffer;
+		}
+		else
+		{
+			if (trace_all || trace_voice) ffnx_trace("NxAudioEngine::%s: cannot load %s\n", __func__, filename.c_str());
+
+			delete stream;
+			stream = nullptr;
+		}
+
+		lock.lock();
+
+		_voicePrefetchLoading.clear();
+
+		if (stream != nullptr)
+		{
+			_voicePrefetchReady[filename] = stream;
+			_voicePrefetchReadyOrder.push_back(filename);
+
+			while (_voicePrefetchReadyOrder.size() > NXAUDIOENGINE_VOICE_PREFETCH_MAX)
+			{
+				auto it = _voicePrefetchReady.find(_voicePrefetchReadyOrder.front());
+
+				if (it != _voicePrefetchReady.end())
+				{
+					delete it->second;
+					_voicePrefetchReady.erase(it);
+				}
+
+				_voicePrefetchReadyOrder.pop_front();
+			}
+		}
+
+		_voicePrefetchDone.notify_all();
+	}
+}
+
+// The files of every candidate are probed here, on the prefetch thread, instead of on the game thread
+bool NxAudioEngine::resolvePrefetchedVoice(const NxAudioEngineVoicePrefetch& request, char* filename)
+{
+	for (const std::string& name : request.names)
+	{
+		if (!getFilenameFullPath(filename, name.c_str(), NxAudioEngineLayer::NXAUDIOENGINE_VOICE)) continue;
+
+		std::string _name(name);
+
+		// Same lookup as playVoice
+		replaceAll(_name, '/', '-');
+
+		const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_VOICE, _name);
+
+		if (track && request.game_moment > -1)
+		{
+			const NxAudioEngineTrackConfig* subtrack = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_VOICE, _name + "/gm-" + std::to_string(request.game_moment));
+			if (subtrack) track = subtrack;
+		}
+
+		// Shuffled or sequential entries will not play the default file
+		if (track && (!track->shuffleNames.empty() || !track->sequentialNames.empty()))
+		{
+			if (trace_all || trace_voice) ffnx_trace("NxAudioEngine::%s: skipping %s, it has shuffle or sequential entries\n", __func__, name.c_str());
+
+			return false;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+SoLoud::VGMStream* NxAudioEngine::takePrefetchedVoice(const char* name, const char* filename)
+{
+	if (!_voicePrefetchThread.joinable()) return nullptr;
+
+	std::unique_lock<std::mutex> lock(_voicePrefetchMutex);
+
+	// Not started yet, loading it here is faster than waiting for the queue
+	auto queued = std::find_if(_voicePrefetchQueue.begin(), _voicePrefetchQueue.end(), [name](const NxAudioEngineVoicePrefetch& request) {
+		return std::find(request.names.begin(), request.names.end(), name) != request.names.end();
+	});
+	if (queued != _voicePrefetchQueue.end()) _voicePrefetchQueue.erase(queued);
+
+	_voicePrefetchDone.wait(lock, [this, filename] { return _voicePrefetchLoading != filename; });
+
+	SoLoud::VGMStream* stream = nullptr;
+	auto it = _voicePrefetchReady.find(filename);
+
+	if (it != _voicePrefetchReady.end())
+	{
+		stream = it->second;
+		_voicePrefetchReady.erase(it);
+		_voicePrefetchReadyOrder.erase(std::find(_voicePrefetchReadyOrder.begin(), _voicePrefetchReadyOrder.end(), filename));
+		_voicePrefetchHits++;
+	}
+	else
+		_voicePrefetchMisses++;
+
+	if (trace_all || trace_voice) ffnx_trace("NxAudioEngine::%s: %s prefetched=%d\n", __func__, filename, stream != nullptr);
+
+	return stream;
+}
+
+void NxAudioEngine::startVoicePrefetch()
+{
+	if (_voicePrefetchThread.joinable()) return;
+
+	_voicePrefetchRunning = true;
+	_voicePrefetchThread = std::thread(&NxAudioEngine::voicePrefetchWorker, this);
+}
+
+void NxAudioEngine::stopVoicePrefetch()
+{
+	if (!_voicePrefetchThread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(_voicePrefetchMutex);
+		_voicePrefetchRunning = false;
+		_voicePrefetchQueue.clear();
+	}
+
+	_voicePrefetchWork.notify_all();
+	_voicePrefetchThread.join();
+
+	for (auto& ready : _voicePrefetchReady) delete ready.second;
+
+	_voicePrefetchReady.clear();
+	_voicePrefetchReadyOrder.clear();
+}
+
+void NxAudioEngine::prefetchVoice(const std::vector<std::string>& names, int game_moment)
+{
+	if (!_voicePrefetchThread.joinable() || names.empty()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(_voicePrefetchMutex);
+
+		// Files already loaded or being loaded are skipped once resolved
+		if (std::find_if(_voicePrefetchQueue.begin(), _voicePrefetchQueue.end(), [&names](const NxAudioEngineVoicePrefetch& request) { return request.names == names; }) != _voicePrefetchQueue.end())
+			return;
+
+		if (trace_all || trace_voice) ffnx_trace("NxAudioEngine::%s: %s\n", __func__, names.front().c_str());
+
+		_voicePrefetchQueue.push_back({ names, game_moment });
+	}
+
+	_voicePrefetchWork.notify_one();
+}
+
+uint32_t NxAudioEngine::getVoicePrefetchHits()
+{
+	return _voicePrefetchHits;
+}
+
+uint32_t NxAudioEngine::getVoicePrefetchMisses()
+{
+	return _voicePrefetchMisses;
+}
+
 float NxAudioEngine::getVoiceMasterVolume()
 {
 	return _voiceMasterVolume < 0.0f ? 1.0f : _voiceMasterVolume;
@@ -1231,56 +1768,50 @@ bool NxAudioEngine::playAmbient(const char* name, float volume, double time)
 	_currentAmbient.fade_out = 0.0f;
 	_currentAmbient.volume = volume * getAmbientMasterVolume();
 
-	auto node = nxAudioEngineConfig[NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT][name];
-	if (node)
+	const NxAudioEngineTrackConfig* track = getTrackConfig(NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT, name);
+	if (track)
 	{
 		// Shuffle Ambient playback, if any entry found for the current id
-		toml::array *shuffleIds = node["shuffle"].as_array();
-		if (shuffleIds && !shuffleIds->empty() && shuffleIds->is_homogeneous(toml::node_type::string))
+		if (!track->shuffleNames.empty())
 		{
-			auto _newName = shuffleIds->get(getRandomInt(0, shuffleIds->size() - 1));
+			const std::string& _newName = track->shuffleNames[getRandomInt(0, track->shuffleNames.size() - 1)];
 
-			exists = getFilenameFullPath(filename, _newName->value_or(""), NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT);
+			exists = getFilenameFullPath(filename, _newName.c_str(), NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT);
 		}
 
 		// Sequentially playback new Ambient ids, if any entry found for the current id
-		toml::array *sequentialIds = node["sequential"].as_array();
-		if (sequentialIds && !sequentialIds->empty() && sequentialIds->is_homogeneous(toml::node_type::string))
+		if (!track->sequentialNames.empty())
 		{
-			// If the key doesn't exist already, add it
-			if (_ambientSequentialIndexes.count(name) == 0) _ambientSequentialIndexes[name] = NULL;
+			int& sequentialIndex = _ambientSequentialIndexes[name];
 
-			if (_ambientSequentialIndexes.find(name) == _ambientSequentialIndexes.end() || _ambientSequentialIndexes[name] >= sequentialIds->size())
-				_ambientSequentialIndexes[name] = 0;
+			if (sequentialIndex >= track->sequentialNames.size())
+				sequentialIndex = 0;
 
-			auto _newName = sequentialIds->get(_ambientSequentialIndexes[name]);
+			const std::string& _newName = track->sequentialNames[sequentialIndex];
 
-			_ambientSequentialIndexes[name]++;
+			sequentialIndex++;
 
-			exists = getFilenameFullPath(filename, _newName->value_or(""), NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT);
+			exists = getFilenameFullPath(filename, _newName.c_str(), NxAudioEngineLayer::NXAUDIOENGINE_AMBIENT);
 		}
 
 		// Fade In time for this track, if configured
-		toml::node *fadeInTime = node["fade_in"].as_floating_point();
-		if (fadeInTime)
+		if (track->fadeIn >= 0.0)
 		{
-			_currentAmbient.fade_in = fadeInTime->value_or(0.0f);
+			_currentAmbient.fade_in = track->fadeIn;
 
 			time = _currentAmbient.fade_in;
 		}
 
 		// Fade Out time for this track, if configured
-		toml::node *fadeOutTime = node["fade_out"].as_floating_point();
-		if (fadeOutTime)
+		if (track->fadeOut >= 0.0)
 		{
-			_currentAmbient.fade_out = fadeOutTime->value_or(0.0f);
+			_currentAmbient.fade_out = track->fadeOut;
 		}
 
 		// Set volume for the current ambient
-		toml::node *ambientVolume = node["volume"].as_integer();
-		if (ambientVolume)
+		if (track->volume != -1)
 		{
-			_currentAmbient.volume = (ambientVolume->value_or(100) / 100.0f) * getAmbientMasterVolume();
+			_currentAmbient.volume = (track->volume / 100.0f) * getAmbientMasterVolume();
 		}
 	}
 
@@ -1482,7 +2013,10 @@ void NxAudioEngine::pushStreamData(uint8_t* data, uint32_t size)
 {
 	if (_currentStream.stream)
 	{
-		_currentStream.stream->push(data, size);
+		if (_currentStream.stream->push(data, size) != SoLoud::SO_NO_ERROR)
+		{
+			if (trace_all || trace_movies) ffnx_trace("NxAudioEngine::%s: stream buffer full, %u bytes partially dropped\n", __func__, size);
+		}
 	}
 }
 
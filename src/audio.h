@@ -24,14 +24,27 @@
 #include <stack>
 #include <string>
 #include <vector>
+#include <list>
+#include <deque>
 #include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <soloud.h>
+#include <soloud_wav.h>
+#include "audio/deinterleave/deinterleave.h"
 #include "audio/memorystream/memorystream.h"
+#include "audio/trackconfig/trackconfig.h"
 #include "audio/vgmstream/vgmstream.h"
 
 #include "log.h"
 
 #define NXAUDIOENGINE_INVALID_HANDLE 0xfffff000
+// Longer SFX keep being streamed from the disk instead of being decoded in the cache
+#define NXAUDIOENGINE_SFX_CACHE_MAX_LENGTH 10.0
+// Maximum number of opened voice streams waiting to be played
+#define NXAUDIOENGINE_VOICE_PREFETCH_MAX 16
 
 static void NxAudioEngineVgmstreamCallback(int level, const char* str)
 {
@@ -74,12 +87,19 @@ public:
 		{}
 		int game_id;
 		int id;
-		SoLoud::VGMStream *stream;
+		SoLoud::AudioSource *stream;
 		SoLoud::handle handle;
 		float volume;
 		bool loop;
 	};
 
+	struct NxAudioEngineSFXCacheEntry
+	{
+		std::string id;
+		SoLoud::Wav* wav;
+		size_t size;
+	};
+
 	struct NxAudioEngineMusic
 	{
 		NxAudioEngineMusic() :
@@ -174,11 +194,25 @@ private:
 	float _sfxMasterVolume = -1.0f;
 	std::map<int, NxAudioEngineSFX> _sfxChannels;
 	std::map<std::string, int> _sfxSequentialIndexes;
-	std::map<int, SoLoud::VGMStream*> _sfxEffectsHandler;
+	std::map<int, SoLoud::AudioSource*> _sfxEffectsHandler;
 	std::vector<short> _sfxLazyUnloadChannels;
 
-	SoLoud::VGMStream* loadSFX(std::string id, bool loop = false);
+	// Decoded short SFX, most recently used first
+	std::list<NxAudioEngineSFXCacheEntry> _sfxCache;
+	std::unordered_map<std::string, std::list<NxAudioEngineSFXCacheEntry>::iterator> _sfxCacheIndex;
+	size_t _sfxCacheSize = 0;
+	uint32_t _sfxCacheHits = 0;
+	uint32_t _sfxCacheMisses = 0;
+	uint64_t _sfxCacheHitTime = 0;
+	uint64_t _sfxCacheMissTime = 0;
+
+	SoLoud::VGMStream* openSFX(const std::string& id, bool loop);
+	SoLoud::AudioSource* loadSFX(std::string id, bool loop = false, bool cacheable = true);
 	void unloadSFXChannel(int channel);
+	SoLoud::Wav* getCachedSFX(const std::string& id);
+	SoLoud::Wav* cacheSFX(const std::string& id, SoLoud::VGMStream* stream);
+	bool isSFXCached(SoLoud::AudioSource* stream);
+	bool isSFXInUse(SoLoud::AudioSource* stream);
 
 	// MUSIC
 	NxAudioEngineMusic _musics[2];
@@ -203,6 +237,29 @@ private:
 	std::map<int, NxAudioEngineVoice> _currentVoice;
 	std::map<std::string, int> _voiceSequentialIndexes;
 
+	// Voice files opened in the background before their dialog page begins, keyed by full path
+	std::thread _voicePrefetchThread;
+	std::mutex _voicePrefetchMutex;
+	std::condition_variable _voicePrefetchWork;
+	std::condition_variable _voicePrefetchDone;
+	bool _voicePrefetchRunning = false;
+	// Candidate names of each requested voice, resolved to a file by the prefetch thread
+	struct NxAudioEngineVoicePrefetch
+	{
+		std::vector<std::string> names;
+		int game_moment;
+	};
+	std::deque<NxAudioEngineVoicePrefetch> _voicePrefetchQueue;
+	std::string _voicePrefetchLoading;
+	std::unordered_map<std::string, SoLoud::VGMStream*> _voicePrefetchReady;
+	std::deque<std::string> _voicePrefetchReadyOrder;
+	uint32_t _voicePrefetchHits = 0;
+	uint32_t _voicePrefetchMisses = 0;
+
+	void voicePrefetchWorker();
+	bool resolvePrefetchedVoice(const NxAudioEngineVoicePrefetch& request, char* filename);
+	SoLoud::VGMStream* takePrefetchedVoice(const char* name, const char* filename);
+
 	// AMBIENT
 	float _ambientMasterVolume = -1.0f;
 	std::map<std::string, int> _ambientSequentialIndexes;
@@ -218,15 +275,26 @@ private:
 	NxAudioEngineStreamAudio _currentStream;
 
 	// MISC
+	// Key to full path of the first existing extension, per layer directory
+	std::unordered_map<NxAudioEngineLayer, std::unordered_map<std::string, std::string>> _fileIndexes;
+	std::atomic<uint32_t> _fileIndexSavedCalls = 0;
+
+	static std::string getFileIndexKey(const std::string& key);
+	const std::vector<std::string>& getLayerExtensions(NxAudioEngineLayer _type);
+	void indexLayer(NxAudioEngineLayer _type, const std::string& dir);
+
 	// Returns false if the file does not exist
 	bool getFilenameFullPath(char *_out, const char* _key, NxAudioEngineLayer _type);
 
 	bool fileExists(const char* filename);
 
 	// CFG
-	std::unordered_map<NxAudioEngineLayer,toml::parse_result> nxAudioEngineConfig;
+	// Voice game moment overrides are stored as "<name>/gm-<moment>", as the / char can't be used in names
+	std::unordered_map<std::string, NxAudioEngineTrackConfig> _trackConfigs[NXAUDIOENGINE_AMBIENT + 1];
 
 	void loadConfig();
+	void compileConfig(NxAudioEngineLayer type, const toml::table& config);
+	const NxAudioEngineTrackConfig* getTrackConfig(NxAudioEngineLayer type, const std::string& name);
 
 public:
 
@@ -234,6 +302,10 @@ public:
 	void flush();
 	void cleanup();
 
+	// Build again the index of the external audio directories, if enabled
+	void indexFiles();
+	uint32_t getFileIndexSavedCalls();
+
 	// SFX
 	int getSFXIdFromChannel(int channel);
 	void unloadSFX(int id);
@@ -250,6 +322,12 @@ public:
 	void setSFXReusableChannels(short num);
 	void setSFXTotalChannels(short num);
 	void addSFXLazyUnloadChannel(int channel);
+	void preloadSFX(const char* name);
+	uint32_t getSFXCacheHits();
+	uint32_t getSFXCacheMisses();
+	// Average time in milliseconds between a play request and its audio source being ready
+	double getSFXCacheHitLatency();
+	double getSFXCacheMissLatency();
 
 	// Music
 	bool canPlayMusic(const char* name);
@@ -284,6 +362,11 @@ public:
 	void resumeVoice(int slot = 0, double time = 0);
 	bool isVoicePlaying(int slot = 0);
 	void setVoiceMaxSlots(int slot);
+	void startVoicePrefetch();
+	void stopVoicePrefetch();
+	void prefetchVoice(const std::vector<std::string>& names, int game_moment = -1);
+	uint32_t getVoicePrefetchHits();
+	uint32_t getVoicePrefetchMisses();
 	float getVoiceMasterVolume();
 	void setVoiceMasterVolume(float volume, double time = 0);
 
@@ -0,0 +1,118 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include "deinterleave.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DEINTERLEAVE_SSE2
+#endif
+
+namespace SoLoud
+{
+	static const float S16_TO_FLOAT = 1.0f / INT16_MAX;
+
+	void deinterleave_s16(float* aBuffer, const int16_t* aSource, uint32_t aSamples, uint32_t aChannels, uint32_t aStride)
+	{
+		uint32_t j = 0;
+
+#ifdef DEINTERLEAVE_SSE2
+		const __m128 scale = _mm_set1_ps(S16_TO_FLOAT);
+
+		if (aChannels == 1)
+		{
+			for (; j + 8 <= aSamples; j += 8)
+			{
+				__m128i s = _mm_loadu_si128((const __m128i*)(aSource + j));
+				// Sign extend by placing each sample in the high half of a 32-bit lane
+				__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+				__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+
+				_mm_storeu_ps(aBuffer + j, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+				_mm_storeu_ps(aBuffer + j + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+			}
+		}
+		else if (aChannels == 2)
+		{
+			float* left = aBuffer;
+			float* right = aBuffer + aStride;
+
+			for (; j + 4 <= aSamples; j += 4)
+			{
+				// L0 R0 L1 R1 L2 R2 L3 R3, each 32-bit lane holds one frame
+				__m128i s = _mm_loadu_si128((const __m128i*)(aSource + j * 2));
+				__m128i l = _mm_srai_epi32(_mm_slli_epi32(s, 16), 16);
+				__m128i r = _mm_srai_epi32(s, 16);
+
+				_mm_storeu_ps(left + j, _mm_mul_ps(_mm_cvtepi32_ps(l), scale));
+				_mm_storeu_ps(right + j, _mm_mul_ps(_mm_cvtepi32_ps(r), scale));
+			}
+		}
+#endif
+
+		for (; j < aSamples; j++)
+		{
+			for (uint32_t k = 0; k < aChannels; k++)
+			{
+				aBuffer[k * aStride + j] = aSource[j * aChannels + k] * S16_TO_FLOAT;
+			}
+		}
+	}
+
+	void deinterleave_f32(float* aBuffer, const float* aSource, uint32_t aSamples, uint32_t aChannels, uint32_t aStride)
+	{
+		if (aChannels == 1)
+		{
+			memcpy(aBuffer, aSource, aSamples * sizeof(float));
+
+			return;
+		}
+
+		uint32_t j = 0;
+
+#ifdef DEINTERLEAVE_SSE2
+		if (aChannels == 2)
+		{
+			float* left = aBuffer;
+			float* right = aBuffer + aStride;
+
+			for (; j + 4 <= aSamples; j += 4)
+			{
+				__m128 a = _mm_loadu_ps(aSource + j * 2);
+				__m128 b = _mm_loadu_ps(aSource + j * 2 + 4);
+
+				_mm_storeu_ps(left + j, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+				_mm_storeu_ps(right + j, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			}
+		}
+#endif
+
+		for (; j < aSamples; j++)
+		{
+			for (uint32_t k = 0; k < aChannels; k++)
+			{
+				aBuffer[k * aStride + j] = aSource[j * aChannels + k];
+			}
+		}
+	}
+};
@@ -0,0 +1,31 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace SoLoud
+{
+	// Convert interleaved samples to the planar layout expected by SoLoud: aBuffer[channel * aStride + sample]
+	void deinterleave_s16(float* aBuffer, const int16_t* aSource, uint32_t aSamples, uint32_t aChannels, uint32_t aStride);
+	void deinterleave_f32(float* aBuffer, const float* aSource, uint32_t aSamples, uint32_t aChannels, uint32_t aStride);
+};
@@ -20,31 +20,42 @@
 /****************************************************************************/
 
 #include "memorystream.h"
+#include "../deinterleave/deinterleave.h"
+
+#include <string.h>
+#include <algorithm>
 
 namespace SoLoud
 {
 	MemoryStreamInstance::MemoryStreamInstance(MemoryStream* aParent)
 	{
 		mParent = aParent;
-		mOffset = 0;
+		mOffset = mParent->mReadOffset.load(std::memory_order_relaxed);
 	}
 
 	uint32_t MemoryStreamInstance::getAudio(float* aBuffer, uint32_t aSamplesToRead, uint32_t aBufferSize)
 	{
-		uint32_t j, k;
-		uint32_t future_offset = mOffset + (aSamplesToRead * mChannels), current_offset = mParent->mPushOffset / sizeof(float);
+		uint32_t length = aSamplesToRead * mChannels, written = mParent->mWriteOffset.load(std::memory_order_acquire);
 
-		if (future_offset <= current_offset)
+		if (written - mOffset >= length)
 		{
-			for (j = 0; j < aSamplesToRead; j++)
+			uint32_t start = mOffset % mParent->mBufferLength;
+
+			if (start + length <= mParent->mBufferLength)
+			{
+				deinterleave_f32(aBuffer, mParent->mData + start, aSamplesToRead, mChannels, aSamplesToRead);
+			}
+			else
 			{
-				for (k = 0; k < mChannels; k++)
-				{
-					aBuffer[k * aSamplesToRead + j] = mParent->mData[mOffset + (j * mChannels) + k];
-				}
+				// The read wraps around the end of the ring buffer, frames never straddle it
+				uint32_t head = (mParent->mBufferLength - start) / mChannels;
+
+				deinterleave_f32(aBuffer, mParent->mData + start, head, mChannels, aSamplesToRead);
+				deinterleave_f32(aBuffer + head, mParent->mData, aSamplesToRead - head, mChannels, aSamplesToRead);
 			}
 
-			mOffset += aSamplesToRead * mChannels;
+			mOffset += length;
+			mParent->mReadOffset.store(mOffset, std::memory_order_release);
 
 			return aSamplesToRead;
 		}
@@ -67,9 +78,12 @@ namespace SoLoud
 		mSampleCount = sampleCount;
 		mChannels = channels;
 
-    mData = new float[mSampleCount]{ NULL };
-    mPushLength = mSampleCount * sizeof(float);
-    mPushOffset = 0;
+    // Whole frames only, so that a frame is never split by the end of the buffer
+    mBufferLength = std::min<uint32_t>(mSampleCount, uint32_t(sampleRate) * MEMORYSTREAM_BUFFER_SECONDS * channels);
+    mBufferLength = std::max<uint32_t>(mBufferLength / channels, 1) * channels;
+    mData = new float[mBufferLength]{ 0 };
+    mWriteOffset = 0;
+    mReadOffset = 0;
 	}
 
 	MemoryStream::~MemoryStream()
@@ -81,15 +95,28 @@ namespace SoLoud
 
   result MemoryStream::push(uint8_t* data, uint32_t size)
   {
-    uint32_t leftSpace = mPushLength - mPushOffset;
+    uint32_t written = mWriteOffset.load(std::memory_order_relaxed), read = mReadOffset.load(std::memory_order_acquire);
+    uint32_t count = size / sizeof(float);
+    uint32_t leftSpace = std::min(mBufferLength - (written - read), mSampleCount - written);
+    result res = SO_NO_ERROR;
+
+    if ( count > leftSpace )
+    {
+      // Keep whole frames, the consumer relies on frames never being split
+      count = leftSpace - (leftSpace % mChannels);
+      res = OUT_OF_MEMORY;
+    }
 
-    if ( size > leftSpace ) size = leftSpace;
+    const float* samples = (const float*)data;
+    uint32_t start = written % mBufferLength;
+    uint32_t head = std::min(count, mBufferLength - start);
 
-    memcpy((uint8_t*)mData + mPushOffset, data, size);
+    memcpy(mData + start, samples, head * sizeof(float));
+    memcpy(mData, samples + head, (count - head) * sizeof(float));
 
-    mPushOffset += size;
+    mWriteOffset.store(written + count, std::memory_order_release);
 
-    return SO_NO_ERROR;
+    return res;
   }
 
 	AudioSourceInstance* MemoryStream::createInstance()
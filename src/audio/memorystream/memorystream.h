@@ -22,21 +22,29 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <soloud.h>
 
+// Seconds of audio which can be pushed ahead of the playback
+#define MEMORYSTREAM_BUFFER_SECONDS 10
+
 namespace SoLoud
 {
+	// Single producer (push) and single consumer (one playing instance) ring buffer of interleaved float samples
 	class MemoryStream : public AudioSource
 	{
 	public:
-		uint32_t mPushLength;
-		uint32_t mPushOffset;
 		uint32_t mSampleCount;
+		uint32_t mBufferLength;
 		float* mData;
+		// Total samples written and read since the beginning of the stream
+		std::atomic<uint32_t> mWriteOffset;
+		std::atomic<uint32_t> mReadOffset;
 
 		MemoryStream(float sampleRate, uint32_t sampleCount, uint32_t channels);
 		virtual ~MemoryStream();
 
+    // Returns OUT_OF_MEMORY if part of the data did not fit in the buffer and was dropped
     result push(uint8_t* data, uint32_t size);
 
 		virtual AudioSourceInstance* createInstance();
@@ -0,0 +1,100 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include "trackconfig.h"
+
+static void compileTrackConfig(std::unordered_map<std::string, NxAudioEngineTrackConfig>& tracks, const std::string& name, const toml::table& node, bool numericIds, bool gameMoments)
+{
+	const toml::node_type idType = numericIds ? toml::node_type::integer : toml::node_type::string;
+
+	NxAudioEngineTrackConfig& track = tracks[name];
+
+	const toml::array* shuffle = node["shuffle"].as_array();
+	if (shuffle && !shuffle->empty() && shuffle->is_homogeneous(idType))
+	{
+		for (auto& elem : *shuffle)
+		{
+			if (numericIds) track.shuffleIds.push_back(elem.value_or(0));
+			else track.shuffleNames.push_back(std::string(elem.value_or("")));
+		}
+	}
+
+	const toml::array* sequential = node["sequential"].as_array();
+	if (sequential && !sequential->empty() && sequential->is_homogeneous(idType))
+	{
+		for (auto& elem : *sequential)
+		{
+			if (numericIds) track.sequentialIds.push_back(elem.value_or(0));
+			else track.sequentialNames.push_back(std::string(elem.value_or("")));
+		}
+	}
+
+	const toml::array* preload = node["preload"].as_array();
+	if (preload && preload->is_homogeneous(toml::node_type::integer))
+	{
+		for (auto& elem : *preload) track.preloadIds.push_back(elem.value_or(0));
+	}
+
+	track.loop = node["loop"].value_or(-1);
+
+	const toml::node* skip = node["skip"].as_boolean();
+	if (skip) track.skip = skip->value_or(false);
+
+	const toml::node* volume = node["volume"].as_integer();
+	if (volume) track.volume = volume->value_or(100);
+
+	const toml::node* fadeIn = node["fade_in"].as_floating_point();
+	if (fadeIn) track.fadeIn = fadeIn->value_or(0.0);
+
+	const toml::node* fadeOut = node["fade_out"].as_floating_point();
+	if (fadeOut) track.fadeOut = fadeOut->value_or(0.0);
+
+	std::optional<bool> disabled = node["disabled"].value<bool>();
+	track.disabled = disabled.has_value() && *disabled;
+
+	track.offsetSeconds = node["offset_seconds"].value<SoLoud::time>();
+	if (!track.offsetSeconds.has_value())
+	{
+		std::optional<std::string> offsetSpecial = node["offset_seconds"].value<std::string>();
+		track.offsetSync = offsetSpecial.has_value() && offsetSpecial->compare("sync") == 0;
+	}
+	track.introSeconds = node["intro_seconds"].value<SoLoud::time>();
+	track.noIntroTrack = node["no_intro_track"].value<std::string>();
+	track.relativeSpeed = node["relative_speed"].value<float>();
+
+	// Voice overrides for specific game moments
+	if (gameMoments)
+	{
+		for (auto&& [subkey, subvalue] : node)
+		{
+			if (subvalue.is_table() && subkey.str().starts_with("gm-"))
+				compileTrackConfig(tracks, name + "/" + std::string(subkey.str()), *subvalue.as_table(), numericIds, gameMoments);
+		}
+	}
+}
+
+void compileTrackConfigs(std::unordered_map<std::string, NxAudioEngineTrackConfig>& tracks, const toml::table& config, bool numericIds, bool gameMoments)
+{
+	for (auto&& [key, value] : config)
+	{
+		if (value.is_table()) compileTrackConfig(tracks, std::string(key.str()), *value.as_table(), numericIds, gameMoments);
+	}
+}
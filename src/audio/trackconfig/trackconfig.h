@@ -0,0 +1,66 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <soloud.h>
+#include <toml++/toml.h>
+
+// Per track options of a config.toml, parsed once at load time
+struct NxAudioEngineTrackConfig
+{
+	NxAudioEngineTrackConfig() :
+		loop(-1),
+		skip(-1),
+		volume(-1),
+		fadeIn(-1.0),
+		fadeOut(-1.0),
+		disabled(false),
+		offsetSync(false) {}
+	// SFX
+	std::vector<int> shuffleIds;
+	std::vector<int> sequentialIds;
+	std::vector<int> preloadIds;
+	int loop;
+	int skip;
+	// Music, Voice and Ambient
+	std::vector<std::string> shuffleNames;
+	std::vector<std::string> sequentialNames;
+	int volume;
+	double fadeIn;
+	double fadeOut;
+	// Music
+	bool disabled;
+	bool offsetSync;
+	std::optional<SoLoud::time> offsetSeconds;
+	std::optional<SoLoud::time> introSeconds;
+	std::optional<std::string> noIntroTrack;
+	std::optional<float> relativeSpeed;
+};
+
+// Adds every track of a config.toml to tracks, keyed by track name
+// SFX refer to other tracks by integer id (numericIds), every other layer by name
+// Voice game moment overrides (gameMoments) are stored as "<name>/gm-<moment>", as the / char can't be used in names
+void compileTrackConfigs(std::unordered_map<std::string, NxAudioEngineTrackConfig>& tracks, const toml::table& config, bool numericIds, bool gameMoments);
@@ -20,6 +20,7 @@
 /****************************************************************************/
 
 #include "vgmstream.h"
+#include "../deinterleave/deinterleave.h"
 #include "../../utils.h"
 
 namespace SoLoud
@@ -39,16 +40,10 @@ namespace SoLoud
 
 	unsigned int VGMStreamInstance::getAudio(float* aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
 	{
-		memset(mStreamBuffer, 0, sizeof(sample_t) * SAMPLE_GRANULARITY * mChannels);
 		int sample_count = render_vgmstream2(mStreamBuffer, aSamplesToRead, mParent->mStream);
 
-		for (int j = 0; j < sample_count; j++)
-		{
-			for (unsigned int k = 0; k < mChannels; k++)
-			{
-				aBuffer[k * aSamplesToRead + j] = mStreamBuffer[(j * mChannels) + k] / (float)INT16_MAX;
-			}
-		}
+		// Only the rendered samples are converted, no need to clear the buffer beforehand
+		deinterleave_s16(aBuffer, mStreamBuffer, sample_count, mChannels, aSamplesToRead);
 
 		mOffset += sample_count;
 
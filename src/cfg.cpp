@@ -156,6 +156,27 @@ long external_ambient_volume;
 long ffmpeg_video_volume;
 bool ff7_advanced_blinking;
 long display_index;
+bool enable_async_texture_loading;
+long async_texture_loading_threads;
+bool enable_mod_path_index;
+bool enable_texture_cache;
+std::string texture_cache_path;
+long texture_cache_size;
+bool enable_draw_call_batching;
+bool enable_threaded_movie_decoding;
+long movie_decode_ahead_frames;
+std::string ffmpeg_video_hwaccel;
+long ffmpeg_video_threads;
+bool enable_async_logging;
+long trace_rate_limit;
+bool enable_direct_path_index;
+bool ff7_lgp_memory_mapping;
+long ff8_decompression_cache_size;
+std::string ff8_decompression_cache_path;
+long external_sfx_cache_size;
+bool enable_audio_file_index;
+bool enable_voice_prefetch;
+bool enable_uniform_cache;
 
 std::vector<std::string> get_string_or_array_of_strings(const toml::node_view<toml::node> &node)
 {
@@ -321,6 +342,27 @@ void read_cfg()
 	ffmpeg_video_volume = config["ffmpeg_video_volume"].value_or(-1);
 	ff7_advanced_blinking = config["ff7_advanced_blinking"].value_or(false);
 	display_index = config["display_index"].value_or(-1);
+	enable_async_texture_loading = config["enable_async_texture_loading"].value_or(false);
+	async_texture_loading_threads = config["async_texture_loading_threads"].value_or(0);
+	enable_mod_path_index = config["enable_mod_path_index"].value_or(false);
+	enable_texture_cache = config["enable_texture_cache"].value_or(false);
+	texture_cache_path = config["texture_cache_path"].value_or("");
+	texture_cache_size = config["texture_cache_size"].value_or(2048);
+	enable_draw_call_batching = config["enable_draw_call_batching"].value_or(false);
+	enable_threaded_movie_decoding = config["enable_threaded_movie_decoding"].value_or(false);
+	movie_decode_ahead_frames = config["movie_decode_ahead_frames"].value_or(8);
+	ffmpeg_video_hwaccel = config["ffmpeg_video_hwaccel"].value_or("");
+	ffmpeg_video_threads = config["ffmpeg_video_threads"].value_or(0);
+	enable_async_logging = config["enable_async_logging"].value_or(false);
+	trace_rate_limit = config["trace_rate_limit"].value_or(0);
+	enable_direct_path_index = config["enable_direct_path_index"].value_or(false);
+	ff7_lgp_memory_mapping = config["ff7_lgp_memory_mapping"].value_or(false);
+	ff8_decompression_cache_size = config["ff8_decompression_cache_size"].value_or(0);
+	ff8_decompression_cache_path = config["ff8_decompression_cache_path"].value_or("");
+	external_sfx_cache_size = config["external_sfx_cache_size"].value_or(0);
+	enable_audio_file_index = config["enable_audio_file_index"].value_or(false);
+	enable_voice_prefetch = config["enable_voice_prefetch"].value_or(false);
+	enable_uniform_cache = config["enable_uniform_cache"].value_or(false);
 
 	// Windows x or y size can't be less then 0
 	if (window_size_x < 0) window_size_x = 0;
@@ -424,6 +466,13 @@ void read_cfg()
 	if (direct_mode_path.empty())
 		direct_mode_path = "direct";
 
+	// TEXTURE CACHE PATH
+	if (texture_cache_path.empty())
+		texture_cache_path = "cache/textures";
+
+	// TEXTURE CACHE SIZE
+	if (texture_cache_size < 0) texture_cache_size = 0;
+
 	// EXTERNAL MOVIE FLAG
 	if (enable_ffmpeg_videos < 0)
 		enable_ffmpeg_videos = !ff8;
@@ -432,6 +481,10 @@ void read_cfg()
 	if (ffmpeg_video_ext.empty())
 		ffmpeg_video_ext = "avi";
 
+	// EXTERNAL MOVIE HARDWARE DECODING
+	if (ffmpeg_video_hwaccel.empty())
+		ffmpeg_video_hwaccel = "none";
+
 	// EXTERNAL MOVIE AUDIO EXTENSION
 	if (external_movie_audio_ext.empty() || external_movie_audio_ext.front().empty())
 		external_movie_audio_ext = std::vector<std::string>(1, "ogg");
@@ -521,4 +574,24 @@ void read_cfg()
 
 	// DISPLAY INDEX
 	if (display_index < 1) display_index = -1;
+
+	// ASYNC TEXTURE LOADING THREADS
+	if (async_texture_loading_threads < 0) async_texture_loading_threads = 0;
+
+	// MOVIE DECODE AHEAD FRAMES
+	if (movie_decode_ahead_frames < 1) movie_decode_ahead_frames = 1;
+
+	// EXTERNAL MOVIE DECODING THREADS
+	if (ffmpeg_video_threads < 0) ffmpeg_video_threads = 0;
+
+	// TRACE RATE LIMIT
+	if (trace_rate_limit < 0) trace_rate_limit = 0;
+
+	// FF8 DECOMPRESSION CACHE
+	if (ff8_decompression_cache_size < 0) ff8_decompression_cache_size = 0;
+	else if (ff8_decompression_cache_size > 512) ff8_decompression_cache_size = 512;
+
+	// EXTERNAL SFX CACHE
+	if (external_sfx_cache_size < 0) external_sfx_cache_size = 0;
+	else if (external_sfx_cache_size > 512) external_sfx_cache_size = 512;
 }
@@ -168,5 +168,26 @@ extern long external_ambient_volume;
 extern long ffmpeg_video_volume;
 extern bool ff7_advanced_blinking;
 extern long display_index;
+extern bool enable_async_texture_loading;
+extern long async_texture_loading_threads;
+extern bool enable_mod_path_index;
+extern bool enable_texture_cache;
+extern std::string texture_cache_path;
+extern long texture_cache_size;
+extern bool enable_draw_call_batching;
+extern bool enable_threaded_movie_decoding;
+extern long movie_decode_ahead_frames;
+extern std::string ffmpeg_video_hwaccel;
+extern long ffmpeg_video_threads;
+extern bool enable_async_logging;
+extern long trace_rate_limit;
+extern bool enable_direct_path_index;
+extern bool ff7_lgp_memory_mapping;
+extern long ff8_decompression_cache_size;
+extern std::string ff8_decompression_cache_path;
+extern long external_sfx_cache_size;
+extern bool enable_audio_file_index;
+extern bool enable_voice_prefetch;
+extern bool enable_uniform_cache;
 
 void read_cfg();
@@ -49,9 +49,13 @@
 #include "patch.h"
 #include "gl.h"
 #include "movies.h"
+#include "video/movies.h"
 #include "music.h"
 #include "sfx.h"
 #include "saveload.h"
+#include "file_index.h"
+#include "image/texture_cache.h"
+#include "image/convert.h"
 #include "gamepad.h"
 #include "joystick.h"
 #include "input.h"
@@ -78,6 +82,7 @@
 #include "ff8/uv_patch.h"
 #include "ff8/ambient.h"
 #include "ff8/file.h"
+#include "ff8/decompression_cache.h"
 
 #include "wine.h"
 
@@ -959,6 +964,25 @@ int common_create_window(HINSTANCE hInstance, struct game_obj* game_object)
 				// Init renderer
 				newRenderer.init();
 
+				// Init texture cache
+				textureCache.init();
+
+				// Init archive decompression cache
+				if (ff8) decompressionCache.init();
+
+				// Init async texture decoder
+				textureDecoder.init();
+
+				// Index external textures
+				if (enable_mod_path_index)
+				{
+					modPathIndex.index(std::string(basedir) + "/" + mod_path);
+					if (!override_mod_path.empty()) modPathIndex.index(std::string(basedir) + "/" + override_mod_path);
+				}
+
+				// Index direct mode files
+				if (enable_direct_path_index) directPathIndex.index(std::string(basedir) + "/" + direct_mode_path);
+
 				// Init GameHacks
 				gamehacks.init();
 
@@ -1095,7 +1119,10 @@ void common_cleanup(struct game_obj *game_object)
 	if(steam_edition || enable_steam_achievements)
 		SteamAPI_Shutdown();
 
+	nxAudioEngine.stopVoicePrefetch();
 	nxAudioEngine.cleanup();
+	textureDecoder.shutdown();
+	textureCache.shutdown();
 	newRenderer.shutdown();
 }
 
@@ -1177,6 +1204,25 @@ void common_flip(struct game_obj *game_object)
 			gl_draw_text(col, row++, color, 255, "Palette changes: %u", stats.palette_changes);
 			gl_draw_text(col, row++, color, 255, "Zsort layers: %u", stats.deferred);
 			gl_draw_text(col, row++, color, 255, "Vertices: %u", stats.vertex_count);
+			gl_draw_text(col, row++, color, 255, "Draw calls: %u (%u submits)", stats.draw_calls, stats.draw_submits);
+			gl_draw_text(col, row++, color, 255, "Uniform uploads: %u KB (%u KB before skipping unchanged ones)", stats.uniform_bytes / 1024, (stats.uniform_bytes + stats.uniform_bytes_skipped) / 1024);
+			gl_draw_text(col, row++, color, 255, "Missing textures: %u (%u lookups skipped)", get_missing_textures_count(), get_missing_textures_hits());
+			if (enable_mod_path_index) gl_draw_text(col, row++, color, 255, "Texture lookups saved: %u", modPathIndex.getSavedCalls());
+			if (enable_direct_path_index) gl_draw_text(col, row++, color, 255, "Direct file lookups saved: %u", directPathIndex.getSavedCalls());
+			if (!ff8)
+			{
+				for (uint32_t lgp_num = 0; lgp_num < sizeof(lgp_stats) / sizeof(lgp_stats[0]); lgp_num++)
+				{
+					if (lgp_stats[lgp_num].opens) gl_draw_text(col, row++, color, 255, "LGP %s: %u opens (%u direct, %u archive, %u missing), %u stdio calls, %u mapped reads", lgp_names[lgp_num], lgp_stats[lgp_num].opens, lgp_stats[lgp_num].direct, lgp_stats[lgp_num].archive, lgp_stats[lgp_num].misses, lgp_stats[lgp_num].stdio_calls, lgp_stats[lgp_num].mapped_reads);
+				}
+			}
+			if (enable_audio_file_index) gl_draw_text(col, row++, color, 255, "Audio file lookups saved: %u", nxAudioEngine.getFileIndexSavedCalls());
+			if (use_external_sfx && external_sfx_cache_size > 0) gl_draw_text(col, row++, color, 255, "SFX cache: %u hits (%.2lf ms), %u misses (%.2lf ms)", nxAudioEngine.getSFXCacheHits(), nxAudioEngine.getSFXCacheHitLatency(), nxAudioEngine.getSFXCacheMisses(), nxAudioEngine.getSFXCacheMissLatency());
+			if (enable_voice_prefetch) gl_draw_text(col, row++, color, 255, "Voice prefetch: %u hits, %u misses", nxAudioEngine.getVoicePrefetchHits(), nxAudioEngine.getVoicePrefetchMisses());
+			if (decompressionCache.isEnabled()) gl_draw_text(col, row++, color, 255, "Decompression cache: %u hits, %u misses (%u from disk), %llu KB saved", decompressionCache.getHitCount(), decompressionCache.getMissCount(), decompressionCache.getDiskHitCount(), decompressionCache.getSavedBytes() / 1024);
+			if (textureCache.isEnabled()) gl_draw_text(col, row++, color, 255, "Texture cache: %u hits, %u transcoded", textureCache.getHitCount(), textureCache.getTranscodedCount());
+			if (textureDecoder.isEnabled()) gl_draw_text(col, row++, color, 255, "Texture decode queue: %u (avg %.1lf ms)", textureDecoder.getQueueDepth(), textureDecoder.getAverageLatency());
+			if (enable_threaded_movie_decoding) gl_draw_text(col, row++, color, 255, "Movie frames decoded ahead: %u (%u dropped)", ffmpeg_get_decoded_frames_ahead(), ffmpeg_get_dropped_frames());
 			gl_draw_text(col, row++, color, 255, "Timer: %I64u", stats.timer);
 		}
 	}
@@ -1245,12 +1291,19 @@ void common_flip(struct game_obj *game_object)
 		}
 	}
 
+	// swap in external textures decoded in background
+	textureDecoder.update();
+
 	// reset per-frame stats
 	stats.texture_reloads = 0;
 	stats.palette_writes = 0;
 	stats.palette_changes = 0;
 	stats.vertex_count = 0;
 	stats.deferred = 0;
+	stats.draw_calls = 0;
+	stats.draw_submits = 0;
+	stats.uniform_bytes = 0;
+	stats.uniform_bytes_skipped = 0;
 
 	newRenderer.show();
 
@@ -1479,6 +1532,9 @@ void common_unload_texture(struct texture_set *texture_set)
 
 	struct gl_texture_set *gl_set = VREF(texture_set, ogl.gl_set);
 
+	// Drop any external texture still being decoded for this set
+	textureDecoder.cancel(gl_set);
+
 	// Destroy original static textures
 	for (uint32_t idx = 0; idx < VREF(texture_set, ogl.gl_set->textures); idx++)
 	{
@@ -1573,6 +1629,7 @@ uint32_t load_external_texture(void* image_data, uint32_t dataSize, struct textu
 	VOBJ(texture_set, texture_set, texture_set);
 	VOBJ(tex_header, tex_header, tex_header);
 	uint32_t texture = 0;
+	bool is_pending = false;
 	struct gl_texture_set *gl_set = VREF(texture_set, ogl.gl_set);
 	struct texture_format* tex_format = VREFP(tex_header, tex_format);
 
@@ -1583,7 +1640,24 @@ uint32_t load_external_texture(void* image_data, uint32_t dataSize, struct textu
 		// Don't use palette index on fallback (for keeping compatibility with Tonberry mods)
 		if(ff8 && _strnicmp(VREF(tex_header, file.pc_name), "field/mapdata/", strlen("field/mapdata/") - 1) == 0) saveload_palette_index |= 0x80000000;
 
-		texture = load_texture(image_data, dataSize, VREF(tex_header, file.pc_name), saveload_palette_index, VREFP(texture_set, ogl.width), VREFP(texture_set, ogl.height), gl_set);
+		// Swap in the external texture once it has been decoded in background
+		uint32_t palette_index = VREF(tex_header, palette_index);
+		TextureDecoderCallback on_ready = [texture_set, palette_index](uint32_t texture, uint32_t width, uint32_t height)
+		{
+			VOBJ(texture_set, texture_set, texture_set);
+
+			VRASS(texture_set, ogl.width, width);
+			VRASS(texture_set, ogl.height, height);
+
+			gl_replace_texture(texture_set, palette_index, texture);
+
+			if(!VREF(texture_set, ogl.external)) stats.external_textures++;
+			VRASS(texture_set, ogl.external, true);
+		};
+
+		texture = load_texture(image_data, dataSize, VREF(tex_header, file.pc_name), saveload_palette_index, VREFP(texture_set, ogl.width), VREFP(texture_set, ogl.height), gl_set, on_ready);
+
+		is_pending = texture == 0 && textureDecoder.isPending(gl_set, saveload_palette_index);
 
 		if (!ff8)
 		{
@@ -1612,6 +1686,14 @@ uint32_t load_external_texture(void* image_data, uint32_t dataSize, struct textu
 		}
 	}
 
+	// Use the converted texture as a placeholder until the external one is ready
+	if(is_pending)
+	{
+		gl_replace_texture(texture_set, VREF(tex_header, palette_index), newRenderer.createTexture((uint8_t*)image_data, originalWidth, originalHeight));
+
+		return true;
+	}
+
 	if(ff8 && texture == 0)
 	{
 		bool external = true;
@@ -1652,24 +1734,10 @@ uint32_t load_external_texture(void* image_data, uint32_t dataSize, struct textu
 	return false;
 }
 
-// convert a single 8-bit paletted pixel to 32-bit BGRA format
-_inline uint32_t pal2bgra(uint32_t pixel, uint32_t *palette, uint32_t palette_offset, uint32_t color_key, uint32_t reference_alpha)
-{
-	if(color_key && pixel == 0) return 0;
-
-	else
-	{
-		uint32_t color = palette[palette_offset + pixel];
-		// FF7 uses a form of alpha keying to emulate PSX blending
-		if(BGRA_A(color) == 0xFE) color = (color & 0xFFFFFF) | reference_alpha;
-		return color;
-	}
-}
-
 // convert an entire image from its native format to 32-bit BGRA
 void convert_image_data(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t w, uint32_t h, struct texture_format *tex_format, uint32_t invert_alpha, uint32_t color_key, uint32_t palette_offset, uint32_t reference_alpha)
 {
-	uint32_t i, j, o = 0, c = 0;
+	uint32_t pixels = w * h;
 
 	// invalid texture in FF8, do not attempt to convert
 	if(ff8 && tex_format->bytesperpixel == 0) return;
@@ -1683,19 +1751,7 @@ void convert_image_data(const unsigned char *image_data, uint32_t *converted_ima
 			return;
 		}
 
-		for(i = 0; i < w; i++)
-		{
-			for(j = 0; j < h; j++)
-			{
-				if(image_data[o] > tex_format->palette_size)
-				{
-					ffnx_glitch("texture conversion error\n");
-					return;
-				}
-
-				converted_image_data[c++] = pal2bgra(image_data[o++], tex_format->palette_data, palette_offset, color_key, reference_alpha);
-			}
-		}
+		if(!convert_paletted(image_data, converted_image_data, pixels, tex_format, color_key, palette_offset, reference_alpha)) ffnx_glitch("texture conversion error\n");
 	}
 	// RGB(A) source data
 	else
@@ -1706,54 +1762,15 @@ void convert_image_data(const unsigned char *image_data, uint32_t *converted_ima
 			return;
 		}
 
-		for(i = 0; i < w; i++)
-		{
-			for(j = 0; j < h; j++)
-			{
-				uint32_t pixel = 0;
-				uint32_t color = 0;
-
-				switch(tex_format->bytesperpixel)
-				{
-					// 16-bit RGB(A)
-					case 2:
-						pixel = *((WORD *)(&image_data[o]));
-						break;
-					// 24-bit RGB
-					case 3:
-						pixel = image_data[o] | image_data[o + 1] << 8 | image_data[o + 2] << 16;
-						break;
-					// 32-bit RGBA or RGBX
-					case 4:
-						pixel = *((uint32_t *)(&image_data[o]));
-						break;
-
-					default:
-						ffnx_glitch("unsupported texture format\n");
-						return;
-				}
-
-				o += tex_format->bytesperpixel;
-
-				// PSX style mask bit
-				if((color_key == 1 && (pixel & ~tex_format->alpha_mask) == 0) || (color_key == 3 && pixel == 0))
-				{
-					converted_image_data[c++] = 0;
-					continue;
-				}
-
-				// convert source data to 8 bits per channel
-				color = tex_format->blue_max > 0 ? ((((pixel & tex_format->blue_mask) >> tex_format->blue_shift) * 255) / tex_format->blue_max) : 0;
-				color |= (tex_format->green_max > 0 ? ((((pixel & tex_format->green_mask) >> tex_format->green_shift) * 255) / tex_format->green_max) : 0) << 8;
-				color |= (tex_format->red_max > 0 ? ((((pixel & tex_format->red_mask) >> tex_format->red_shift) * 255) / tex_format->red_max) : 0) << 16;
-
-				// special case to deal with poorly converted PSX images in FF7
-				if(invert_alpha && pixel != 0x8000) color |= (tex_format->alpha_max > 0 ? (255 - ((((pixel & tex_format->alpha_mask) >> tex_format->alpha_shift) * 255) / tex_format->alpha_max)) : 255) << 24;
-				else color |= (tex_format->alpha_max > 0 ? ((((pixel & tex_format->alpha_mask) >> tex_format->alpha_shift) * 255) / tex_format->alpha_max) : 255) << 24;
+		if(pixels == 0) return;
 
-				converted_image_data[c++] = color;
-			}
+		if(tex_format->bytesperpixel < 2 || tex_format->bytesperpixel > 4)
+		{
+			ffnx_glitch("unsupported texture format\n");
+			return;
 		}
+
+		convert_rgba(image_data, converted_image_data, pixels, tex_format, invert_alpha, color_key);
 	}
 }
 
@@ -2998,6 +3015,8 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 
 		read_cfg();
 
+		if (enable_async_logging) start_applog_writer();
+
 		// Did user choose to enable Widescreen?
 		widescreen_enabled = (aspect_ratio == AR_WIDESCREEN_16X9 || aspect_ratio == AR_WIDESCREEN_16X10);
 
@@ -3191,6 +3210,9 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 	}
 	else if (fdwReason == DLL_PROCESS_DETACH)
 	{
+		// other threads are already gone at this point, write what they have left in the log
+		flush_applog();
+
 		unreplace_functions();
 	}
 
@@ -342,6 +342,10 @@ struct driver_stats
 	uint32_t palette_changes;
 	uint32_t vertex_count;
 	uint32_t deferred;
+	uint32_t draw_calls;
+	uint32_t draw_submits;
+	uint32_t uniform_bytes;
+	uint32_t uniform_bytes_skipped;
 	time_t timer;
 };
 
@@ -71,6 +71,7 @@ LONG WINAPI ExceptionHandler(EXCEPTION_POINTERS *ep)
 	if(had_exception)
 	{
 		ffnx_unexpected("ExceptionHandler: crash while running another ExceptionHandler. Exiting.");
+		flush_applog();
 		SetUnhandledExceptionFilter(0);
 		return EXCEPTION_CONTINUE_EXECUTION;
 	}
@@ -161,6 +162,9 @@ LONG WINAPI ExceptionHandler(EXCEPTION_POINTERS *ep)
 
 	ffnx_error("Unhandled Exception. See dumped information above.\n");
 
+	// the log writer thread may not run again, make sure the stack trace reaches the log
+	flush_applog();
+
 	TASKDIALOGCONFIG config = { sizeof(config) };
 	config.hwndParent = gameHwnd;
 	config.dwFlags = TDF_ENABLE_HYPERLINKS;
@@ -63,7 +63,8 @@ protected:
     {
         if (! _muted)
         {
-            ffnx_trace(szText);
+            // the stack trace is logged from a single call site, it must not be cut by trace_rate_limit
+            debug_printf("TRACE", text_colors[TEXTCOLOR_GREEN], "%s", szText);
         }
     }
 private:
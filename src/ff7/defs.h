@@ -67,9 +67,20 @@ void ff7_character_regularly_field_entity_60FA7D(WORD param1, short param2, shor
 int ff7_load_save_file(int param_1);
 
 // file
+struct lgp_stats
+{
+	uint32_t opens;
+	uint32_t direct;
+	uint32_t archive;
+	uint32_t misses;
+	uint32_t stdio_calls;
+	uint32_t mapped_reads;
+};
+
 FILE *open_lgp_file(char *filename, uint32_t mode);
 void close_lgp_file(FILE *fd);
 extern char lgp_names[18][256];
+extern struct lgp_stats lgp_stats[18];
 uint32_t lgp_chdir(char *path);
 struct lgp_file *lgp_open_file(char *filename, uint32_t lgp_num);
 uint32_t lgp_seek_file(uint32_t offset, uint32_t lgp_num);
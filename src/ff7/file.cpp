@@ -22,10 +22,34 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <io.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "../ff7.h"
 #include "../log.h"
 #include "../redirect.h"
+#include "../file_index.h"
+
+// read-only view of an opened LGP archive, used instead of stdio when ff7_lgp_memory_mapping is enabled
+struct lgp_mapping
+{
+	FILE *fd = nullptr;
+	HANDLE mapping = nullptr;
+	const char *data = nullptr;
+	uint32_t size = 0;
+	uint32_t position = 0;
+};
+
+struct lgp_mapping lgp_mappings[18];
+
+void unmap_lgp_file(struct lgp_mapping &map)
+{
+	if(map.data) UnmapViewOfFile(map.data);
+	if(map.mapping) CloseHandle(map.mapping);
+
+	map = lgp_mapping();
+}
 
 FILE *open_lgp_file(char *filename, uint32_t mode)
 {
@@ -48,6 +72,11 @@ void close_lgp_file(FILE *fd)
 
 	if(trace_all || trace_files) ffnx_trace("closing lgp file\n");
 
+	for(struct lgp_mapping &map : lgp_mappings)
+	{
+		if(map.fd == fd) unmap_lgp_file(map);
+	}
+
 	fclose(fd);
 }
 
@@ -86,6 +115,19 @@ struct lgp_file
 
 #define NUM_LGP_FILES 64
 
+// lowercase file names of an LGP TOC, duplicated names are resolved through their conflict directories
+struct lgp_toc_index
+{
+	struct lgp_toc_entry *toc = nullptr;
+	uint32_t num_files = 0;
+	std::unordered_map<std::string, std::vector<uint32_t>> files;
+	std::unordered_map<uint32_t, std::unordered_map<std::string, uint32_t>> conflicts;
+};
+
+struct lgp_toc_index lgp_toc_indexes[18];
+
+struct lgp_stats lgp_stats[18];
+
 struct lgp_file *lgp_files[NUM_LGP_FILES];
 uint32_t lgp_files_index = 0;
 
@@ -123,84 +165,127 @@ uint32_t lgp_chdir(char *path)
 	return true;
 }
 
-// original LGP open file logic, unchanged except for the LGP Tools safety net
+std::string lgp_index_key(const char *name, size_t max_length)
+{
+	std::string ret(name, strnlen(name, max_length));
+
+	for (char &c : ret) c = ::tolower((unsigned char)c);
+
+	return ret;
+}
+
+// built the first time a file is opened in this LGP, and again if the game loads another TOC
+struct lgp_toc_index &get_lgp_toc_index(uint32_t lgp_num)
+{
+	struct lgp_toc_index &index = lgp_toc_indexes[lgp_num];
+	struct lgp_toc_entry *toc = ff7_externals.lgp_tocs[lgp_num * 2];
+	uint32_t num_files = ((uint32_t *)ff7_externals.lgp_tocs)[lgp_num * 2 + 1];
+
+	if(index.toc == toc && index.num_files == num_files) return index;
+
+	index.toc = toc;
+	index.num_files = num_files;
+	index.files.clear();
+	index.conflicts.clear();
+	index.files.reserve(num_files);
+
+	for(uint32_t i = 0; i < num_files; i++)
+	{
+		index.files[lgp_index_key(toc[i].name, sizeof(toc[i].name))].push_back(i);
+
+		uint32_t conflict_id = toc[i].conflict;
+
+		if(conflict_id && !index.conflicts.contains(conflict_id))
+		{
+			struct conflict_list *conflict = &ff7_externals.lgp_folders[lgp_num].conflicts[conflict_id - 1];
+			std::unordered_map<std::string, uint32_t> &dirs = index.conflicts[conflict_id];
+
+			for(uint32_t j = 0; j < conflict->num_conflicts; j++)
+				dirs.try_emplace(lgp_index_key(conflict->conflict_entries[j].name, sizeof(conflict->conflict_entries[j].name)), conflict->conflict_entries[j].toc_index);
+		}
+	}
+
+	if(trace_all || trace_files) ffnx_trace("indexed %u files (%u names, %u conflicts) in %s LGP\n", num_files, uint32_t(index.files.size()), uint32_t(index.conflicts.size()), lgp_names[lgp_num]);
+
+	return index;
+}
+
+// original LGP open file logic, answered from the TOC index instead of comparing names one by one
 uint32_t original_lgp_open_file(char *filename, uint32_t lgp_num, struct lgp_file *ret)
 {
 	uint32_t lookup_value1 = lgp_lookup_value(filename[0]);
 	uint32_t lookup_value2 = lgp_lookup_value(filename[1]) + 1;
 	struct lookup_table_entry *lookup_table = ff7_externals.lgp_lookup_tables[lgp_num];
 	uint32_t toc_offset = lookup_table[lookup_value1 * 30 + lookup_value2].toc_offset;
-	uint32_t i;
+	struct lgp_toc_index &index = get_lgp_toc_index(lgp_num);
+
+	auto file = index.files.find(lgp_index_key(filename, strlen(filename)));
+
+	if(file == index.files.end()) return false;
 
 	// did we find anything in the lookup table?
 	if(toc_offset)
 	{
 		uint32_t num_files = lookup_table[lookup_value1 * 30 + lookup_value2].num_files;
 
-		// look for our file
-		for(i = 0; i < num_files; i++)
+		// look for the first file with this name in the range given by the lookup table
+		for(uint32_t i : file->second)
 		{
-			struct lgp_toc_entry *toc_entry = &ff7_externals.lgp_tocs[lgp_num * 2][toc_offset + i - 1];
+			if(i < toc_offset - 1 || i >= toc_offset - 1 + num_files) continue;
+
+			struct lgp_toc_entry *toc_entry = &index.toc[i];
 
-			if(!_stricmp(toc_entry->name, filename))
+			if(!toc_entry->conflict)
 			{
-				if(!toc_entry->conflict)
-				{
-					// this is the only file with this name, we're done here
-					ret->is_lgp_offset = true;
-					ret->offset = toc_entry->offset;
-					return true;
-				}
-				else
-				{
-					struct conflict_list *conflict = &ff7_externals.lgp_folders[lgp_num].conflicts[toc_entry->conflict - 1];
-					struct conflict_entry *conflict_entries = conflict->conflict_entries;
-					uint32_t num_conflicts = conflict->num_conflicts;
-
-					// there are multiple files with this name, look for our
-					// current directory in the conflict table
-					for(i = 0; i < num_conflicts; i++)
-					{
-						if(!_stricmp(conflict_entries[i].name, lgp_current_dir))
-						{
-							struct lgp_toc_entry *toc_entry = &ff7_externals.lgp_tocs[lgp_num * 2][conflict_entries[i].toc_index];
-
-							// file name and directory matches, this is our file
-							ret->is_lgp_offset = true;
-							ret->offset = toc_entry->offset;
-							ret->resolved_conflict = true;
-							return true;
-						}
-					}
+				// this is the only file with this name, we're done here
+				ret->is_lgp_offset = true;
+				ret->offset = toc_entry->offset;
+				return true;
+			}
 
-					break;
-				}
+			// there are multiple files with this name, look for our
+			// current directory in the conflict table
+			std::unordered_map<std::string, uint32_t> &dirs = index.conflicts[toc_entry->conflict];
+			auto dir = dirs.find(lgp_index_key(lgp_current_dir, sizeof(lgp_current_dir)));
+
+			if(dir != dirs.end())
+			{
+				// file name and directory matches, this is our file
+				ret->is_lgp_offset = true;
+				ret->offset = index.toc[dir->second].offset;
+				ret->resolved_conflict = true;
+				return true;
 			}
+
+			break;
 		}
 	}
 
 	// one last chance, the lookup table might have been broken by LGP Tools,
-	// search through the entire archive
-	for(i = 0; i < ((uint32_t *)ff7_externals.lgp_tocs)[lgp_num * 2 + 1]; i++)
-	{
-		struct lgp_toc_entry *toc_entry = &ff7_externals.lgp_tocs[lgp_num * 2][i];
+	// take any file with this name in the entire archive
+	ffnx_glitch("broken LGP file (%s), don't use LGP Tools!\n", lgp_names[lgp_num]);
 
-		if(!_stricmp(toc_entry->name, filename))
+	for(uint32_t i : file->second)
+	{
+		if(!index.toc[i].conflict)
 		{
-			ffnx_glitch("broken LGP file (%s), don't use LGP Tools!\n", lgp_names[lgp_num]);
-
-			if(!toc_entry->conflict)
-			{
-				ret->is_lgp_offset = true;
-				ret->offset = toc_entry->offset;
-				return true;
-			}
+			ret->is_lgp_offset = true;
+			ret->offset = index.toc[i].offset;
+			return true;
 		}
 	}
 
 	return false;
 }
 
+// direct mode files are checked against directPathIndex when it is enabled, so missing ones never reach fopen
+FILE *open_direct_file(const char *path)
+{
+	if(enable_direct_path_index && !directPathIndex.exists(path)) return nullptr;
+
+	return fopen(path, "rb");
+}
+
 // new LGP open file logic with modpath and direct mode support
 struct lgp_file *lgp_open_file(char *filename, uint32_t lgp_num)
 {
@@ -213,15 +298,17 @@ struct lgp_file *lgp_open_file(char *filename, uint32_t lgp_num)
 
 	_splitpath(filename, 0, 0, fname, ext);
 
+	lgp_stats[lgp_num].opens++;
+
 	if(!direct_mode_path.empty())
 	{
 		_snprintf(tmp, sizeof(tmp), "%s/%s/%s/%s%s", basedir, direct_mode_path.c_str(), lgp_names[lgp_num], fname, ext);
-		ret->fd = fopen(tmp, "rb");
+		ret->fd = open_direct_file(tmp);
 
 		if(!ret->fd)
 		{
 			_snprintf(tmp, sizeof(tmp), "%s/%s/%s.lgp/%s%s", basedir, direct_mode_path.c_str(), lgp_names[lgp_num], fname, ext);
-			ret->fd = fopen(tmp, "rb");
+			ret->fd = open_direct_file(tmp);
 		}
 
 		// Try to load special language named lgp files
@@ -233,22 +320,25 @@ struct lgp_file *lgp_open_file(char *filename, uint32_t lgp_num)
 				case 15: // cr
 				case 16: // disc
 					_snprintf(tmp, sizeof(tmp), "%s/%s/%s_us.lgp/%s%s", basedir, direct_mode_path.c_str(), lgp_names[lgp_num], fname, ext);
+					ret->fd = open_direct_file(tmp);
 					break;
 				case 8: // high
 				case 10: // snowboard
 					_snprintf(tmp, sizeof(tmp), "%s/%s/%s-us.lgp/%s%s", basedir, direct_mode_path.c_str(), lgp_names[lgp_num], fname, ext);
+					ret->fd = open_direct_file(tmp);
 					break;
 			}
-			ret->fd = fopen(tmp, "rb");
 		}
 
 		if(!ret->fd)
 		{
 			_snprintf(tmp, sizeof(tmp), "%s/%s/%s/%s/%s%s", basedir, direct_mode_path.c_str(), lgp_names[lgp_num], lgp_current_dir, fname, ext);
-			ret->fd = fopen(tmp, "rb");
+			ret->fd = open_direct_file(tmp);
 			if(ret->fd) ret->resolved_conflict = true;
 		}
 
+		if(ret->fd) lgp_stats[lgp_num].direct++;
+
 		if(ret->fd && (trace_all || trace_direct)) ffnx_trace("lgp_open_file: %i, %s (%s) [%s] = 0x%x\n", lgp_num, filename, lgp_current_dir, tmp, ret);
 	}
 
@@ -260,10 +350,13 @@ struct lgp_file *lgp_open_file(char *filename, uint32_t lgp_num)
 		{
 			if(!direct_mode_path.empty()) ffnx_error("failed to find file %s; tried %s/%s/%s, %s/%s/%s/%s, %s/%s (LGP) (path: %s)\n", filename, direct_mode_path.c_str(), lgp_names[lgp_num], name, direct_mode_path.c_str(), lgp_names[lgp_num], lgp_current_dir, name, lgp_names[lgp_num], name, lgp_current_dir);
 			else ffnx_error("failed to find file %s/%s (LGP) (path: %s)\n", lgp_names[lgp_num], name, lgp_current_dir);
+			lgp_stats[lgp_num].misses++;
 			external_free(ret);
 			return 0;
 		}
 
+		lgp_stats[lgp_num].archive++;
+
 		if(trace_all || trace_direct) ffnx_trace("lgp_open_file: %i, %s (%s) [ORIGINAL] = 0x%x\n", lgp_num, filename, lgp_current_dir, ret);
 	}
 
@@ -290,22 +383,97 @@ struct lgp_file *lgp_open_file(char *filename, uint32_t lgp_num)
  * these in a way that works with the original code.
  */
 
+// map the archive the first time it is accessed, returns nullptr if it cannot be mapped so stdio is used instead
+struct lgp_mapping *get_lgp_mapping(uint32_t lgp_num)
+{
+	FILE *fd = ff7_externals.lgp_fds[lgp_num];
+	struct lgp_mapping &map = lgp_mappings[lgp_num];
+
+	if(!ff7_lgp_memory_mapping || !fd) return nullptr;
+
+	if(map.fd == fd) return map.data ? &map : nullptr;
+
+	unmap_lgp_file(map);
+	map.fd = fd;
+
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno(fd));
+	LARGE_INTEGER size;
+
+	if(file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &size) && size.QuadPart > 0 && !size.HighPart)
+	{
+		map.mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if(map.mapping) map.data = (const char *)MapViewOfFile(map.mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+
+	if(!map.data)
+	{
+		ffnx_warning("could not map %s LGP file (error %u), falling back to regular reads\n", lgp_names[lgp_num], GetLastError());
+
+		// remember the failure so it is not attempted again until the archive is reopened
+		unmap_lgp_file(map);
+		map.fd = fd;
+
+		return nullptr;
+	}
+
+	map.size = size.LowPart;
+
+	if(trace_all || trace_files) ffnx_trace("mapped %s LGP file (%u bytes)\n", lgp_names[lgp_num], map.size);
+
+	return &map;
+}
+
+// copy from the mapped archive, short reads past the end behave like fread
+uint32_t lgp_read_mapping(struct lgp_mapping *map, uint32_t lgp_num, char *dest, uint32_t size)
+{
+	uint32_t available = map->position < map->size ? map->size - map->position : 0;
+
+	if(size > available) size = available;
+
+	memcpy(dest, map->data + map->position, size);
+	map->position += size;
+
+	lgp_stats[lgp_num].mapped_reads++;
+
+	return size;
+}
+
 // seek to given offset in LGP file
 uint32_t lgp_seek_file(uint32_t offset, uint32_t lgp_num)
 {
 	if(!ff7_externals.lgp_fds[lgp_num]) return false;
 
-	fseek(ff7_externals.lgp_fds[lgp_num], offset, SEEK_SET);
+	struct lgp_mapping *map = get_lgp_mapping(lgp_num);
+
+	if(map) map->position = offset;
+	else
+	{
+		fseek(ff7_externals.lgp_fds[lgp_num], offset, SEEK_SET);
+		lgp_stats[lgp_num].stdio_calls++;
+	}
 
 	return true;
 }
 
+// read from the archive itself, at the position set by lgp_seek_file
+uint32_t lgp_read_archive(uint32_t lgp_num, char *dest, uint32_t size)
+{
+	struct lgp_mapping *map = get_lgp_mapping(lgp_num);
+
+	if(map) return lgp_read_mapping(map, lgp_num, dest, size);
+
+	lgp_stats[lgp_num].stdio_calls++;
+
+	return fread(dest, 1, size, ff7_externals.lgp_fds[lgp_num]);
+}
+
 // read straight from LGP file
 uint32_t lgp_read(uint32_t lgp_num, char *dest, uint32_t size)
 {
 	if(!ff7_externals.lgp_fds[lgp_num]) return 0;
 
-	if(last->is_lgp_offset) return fread(dest, 1, size, ff7_externals.lgp_fds[lgp_num]);
+	if(last->is_lgp_offset) return lgp_read_archive(lgp_num, dest, size);
 
 	return fread(dest, 1, size, last->fd);
 }
@@ -318,7 +486,7 @@ uint32_t lgp_read_file(struct lgp_file *file, uint32_t lgp_num, char *dest, uint
 	if(file->is_lgp_offset)
 	{
 		lgp_seek_file(file->offset + 24, lgp_num);
-		return fread(dest, 1, size, ff7_externals.lgp_fds[lgp_num]);
+		return lgp_read_archive(lgp_num, dest, size);
 	}
 
 	return fread(dest, 1, size, file->fd);
@@ -332,7 +500,7 @@ uint32_t lgp_get_filesize(struct lgp_file *file, uint32_t lgp_num)
 		uint32_t size;
 
 		lgp_seek_file(file->offset + 20, lgp_num);
-		fread(&size, 4, 1, ff7_externals.lgp_fds[lgp_num]);
+		lgp_read_archive(lgp_num, (char *)&size, 4);
 		return size;
 	}
 	else
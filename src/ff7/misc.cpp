@@ -670,6 +670,7 @@ void ff7_handle_ambient_playback()
 			last_battle_id = ff7_externals.modules_global_object->battle_id;
 
 			sprintf(filename, "bat_%d", last_battle_id);
+			if (use_external_sfx) nxAudioEngine.preloadSFX(filename);
 			nxAudioEngine.playAmbient(filename);
 		}
 		if (*ff7_externals.is_battle_paused && nxAudioEngine.isAmbientPlaying())
@@ -683,6 +684,9 @@ void ff7_handle_ambient_playback()
 			last_field_id = *common_externals.current_field_id;
 			last_triangle_id = *common_externals.current_triangle_id;
 
+			sprintf(filename, "field_%d", last_field_id);
+			if (use_external_sfx) nxAudioEngine.preloadSFX(filename);
+
 			sprintf(filename, "field_%d_%d", last_field_id, *common_externals.current_triangle_id);
 			playing = nxAudioEngine.playAmbient(filename);
 
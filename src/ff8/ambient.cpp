@@ -39,6 +39,7 @@ void ff8_handle_ambient_playback()
 			last_battle_id = next_battle_scene_id;
 
 			sprintf(filename, "bat_%d", last_battle_id);
+			if (use_external_sfx) nxAudioEngine.preloadSFX(filename);
 			nxAudioEngine.playAmbient(filename);
 		}
 		if ((*ff8_externals.is_game_paused != 0) && nxAudioEngine.isAmbientPlaying())
@@ -51,6 +52,9 @@ void ff8_handle_ambient_playback()
 		{
 			last_field_id = *common_externals.current_field_id;
 
+			sprintf(filename, "field_%d", last_field_id);
+			if (use_external_sfx) nxAudioEngine.preloadSFX(filename);
+
 			if (common_externals.current_triangle_id != 0)
 			{
 				last_triangle_id = *common_externals.current_triangle_id;
@@ -0,0 +1,211 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include <filesystem>
+#include <xxhash.h>
+#include <lz4.h>
+#include <lz4hc.h>
+
+#include "decompression_cache.h"
+
+#include "../log.h"
+
+DecompressionCache decompressionCache;
+
+// PRIVATE
+
+std::string DecompressionCache::getCachedFilename(uint64_t key)
+{
+	char cachedFilename[sizeof(basedir) + 1024]{ 0 };
+
+	_snprintf(cachedFilename, sizeof(cachedFilename), "%s/%016llx.lz4", path.c_str(), key);
+
+	return cachedFilename;
+}
+
+bool DecompressionCache::loadFromDisk(uint64_t key, uint8_t* target, size_t size)
+{
+	std::string cachedFilename = getCachedFilename(key);
+	FILE* file = fopen(cachedFilename.c_str(), "rb");
+
+	if (!file) return false;
+
+	std::vector<char> compressed(LZ4_compressBound(size));
+	size_t compressedSize = fread(compressed.data(), 1, compressed.size(), file);
+
+	fclose(file);
+
+	int uncompressedSize = LZ4_decompress_safe(compressed.data(), (char*)target, compressedSize, size);
+
+	if (uncompressedSize != int(size))
+	{
+		ffnx_warning("%s: ignoring corrupted cache file %s\n", __func__, cachedFilename.c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+void DecompressionCache::saveToDisk(uint64_t key, const uint8_t* data, size_t size)
+{
+	std::vector<char> compressed(LZ4_compressBound(size));
+	int compressedSize = LZ4_compress_HC((const char*)data, compressed.data(), size, compressed.size(), LZ4HC_CLEVEL_DEFAULT);
+
+	if (compressedSize <= 0) return;
+
+	std::string cachedFilename = getCachedFilename(key);
+	// Write to a temporary file first, so an interrupted write never leaves a truncated cache entry behind
+	std::string tmpFilename = cachedFilename + ".tmp";
+	FILE* file = fopen(tmpFilename.c_str(), "wb");
+
+	if (!file) return;
+
+	bool written = fwrite(compressed.data(), 1, compressedSize, file) == size_t(compressedSize);
+
+	fclose(file);
+
+	std::error_code ec;
+
+	if (written) std::filesystem::rename(tmpFilename, cachedFilename, ec);
+
+	if (!written || ec)
+	{
+		ffnx_error("%s: could not write %s\n", __func__, cachedFilename.c_str());
+
+		std::filesystem::remove(tmpFilename, ec);
+	}
+}
+
+void DecompressionCache::insert(uint64_t key, const uint8_t* data, size_t size)
+{
+	// Files bigger than half the cache would evict most of it for a single entry
+	if (size > maxSize / 2) return;
+
+	while (currentSize + size > maxSize)
+	{
+		currentSize -= entries.back().data.size();
+		lookup.erase(entries.back().key);
+		entries.pop_back();
+	}
+
+	entries.push_front({ key, std::vector<uint8_t>(data, data + size) });
+	lookup[key] = entries.begin();
+	currentSize += size;
+}
+
+// PUBLIC
+
+void DecompressionCache::init()
+{
+	if (ff8_decompression_cache_size <= 0) return;
+
+	maxSize = size_t(ff8_decompression_cache_size) * 1024 * 1024;
+
+	if (!ff8_decompression_cache_path.empty())
+	{
+		path = std::string(basedir) + "/" + ff8_decompression_cache_path;
+
+		std::error_code ec;
+
+		std::filesystem::create_directories(path, ec);
+
+		if (ec)
+		{
+			ffnx_error("Decompression cache will not be persisted: could not create %s\n", path.c_str());
+
+			path.clear();
+		}
+	}
+
+	ffnx_info("Decompression cache enabled (%ld MB%s%s)\n", ff8_decompression_cache_size, path.empty() ? "" : ", persisted in ", path.c_str());
+}
+
+bool DecompressionCache::isEnabled()
+{
+	return maxSize > 0;
+}
+
+uint64_t DecompressionCache::getKey(uint32_t compressionType, const uint8_t* source, size_t sourceSize, size_t targetSize)
+{
+	return XXH3_64bits_withSeed(source, sourceSize, (uint64_t(compressionType) << 32) | targetSize);
+}
+
+bool DecompressionCache::load(uint64_t key, uint8_t* target, size_t size)
+{
+	auto it = lookup.find(key);
+
+	if (it != lookup.end() && it->second->data.size() == size)
+	{
+		entries.splice(entries.begin(), entries, it->second);
+		memcpy(target, it->second->data.data(), size);
+
+		hitCount++;
+		savedBytes += size;
+
+		return true;
+	}
+
+	missCount++;
+
+	if (!path.empty() && loadFromDisk(key, target, size))
+	{
+		diskHitCount++;
+
+		if (trace_all || trace_files) ffnx_trace("%s: using %s\n", __func__, getCachedFilename(key).c_str());
+
+		insert(key, target, size);
+
+		return true;
+	}
+
+	return false;
+}
+
+void DecompressionCache::store(uint64_t key, uint32_t compressionType, const uint8_t* data, size_t size)
+{
+	if (lookup.contains(key)) return;
+
+	insert(key, data, size);
+
+	// LZ4 files are already fast to decompress, only LZS ones are worth persisting
+	if (!path.empty() && compressionType != 2) saveToDisk(key, data, size);
+}
+
+uint32_t DecompressionCache::getHitCount()
+{
+	return hitCount;
+}
+
+uint32_t DecompressionCache::getMissCount()
+{
+	return missCount;
+}
+
+uint32_t DecompressionCache::getDiskHitCount()
+{
+	return diskHitCount;
+}
+
+uint64_t DecompressionCache::getSavedBytes()
+{
+	return savedBytes;
+}
@@ -0,0 +1,75 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+// Keeps decompressed FF8 archive files in memory, keyed by the hash of their compressed data.
+// LZS files can also be kept on disk recompressed with LZ4-HC, which is much faster to decompress on the next sessions.
+class DecompressionCache {
+private:
+	struct Entry
+	{
+		uint64_t key;
+		std::vector<uint8_t> data;
+	};
+
+	// Most recently used first
+	std::list<Entry> entries;
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> lookup;
+	size_t maxSize = 0;
+	size_t currentSize = 0;
+
+	std::string path;
+
+	uint32_t hitCount = 0;
+	uint32_t missCount = 0;
+	uint32_t diskHitCount = 0;
+	uint64_t savedBytes = 0;
+
+	std::string getCachedFilename(uint64_t key);
+	bool loadFromDisk(uint64_t key, uint8_t* target, size_t size);
+	void saveToDisk(uint64_t key, const uint8_t* data, size_t size);
+	void insert(uint64_t key, const uint8_t* data, size_t size);
+
+public:
+	void init();
+
+	bool isEnabled();
+
+	uint64_t getKey(uint32_t compressionType, const uint8_t* source, size_t sourceSize, size_t targetSize);
+
+	// Copies the decompressed data to target and returns true if it is cached
+	bool load(uint64_t key, uint8_t* target, size_t size);
+	void store(uint64_t key, uint32_t compressionType, const uint8_t* data, size_t size);
+
+	uint32_t getHitCount();
+	uint32_t getMissCount();
+	uint32_t getDiskHitCount();
+	uint64_t getSavedBytes();
+};
+
+extern DecompressionCache decompressionCache;
@@ -25,16 +25,39 @@
 #include "../ff8.h"
 #include "../log.h"
 #include "../redirect.h"
+#include "../file_index.h"
+#include "decompression_cache.h"
 
 #include <fcntl.h>
 #include <io.h>
 #include <lz4.h>
+#include <xxhash.h>
+#include <unordered_map>
+#include <vector>
 
 char next_direct_file[MAX_PATH] = "";
 bool last_fopen_is_redirected = false;
 uint32_t last_compression_type = 0;
 size_t last_compressed_size = 0;
 size_t last_uncompressed_size = 0;
+size_t last_source_size = 0;
+size_t last_target_size = 0;
+
+// Files listed in an archive .fl, keyed by their lowercase path without the language prefix.
+// Several languages of the same file can be in one archive, ids are kept in .fl order.
+struct ff8_fl_index
+{
+	const ff8_file_fl *fl_infos = nullptr;
+	int file_count = 0;
+	const char *filenames_data = nullptr;
+	int filenames_data_size = 0;
+	XXH64_hash_t filenames_hash = 0;
+	std::unordered_map<std::string, std::vector<int>> ids;
+};
+
+// Containers closed through moriya_filesystem_close drop their index in ff8_fs_archive_free_file_container_sub_archive.
+// A container allocated again at the same address with new .fl data is still detected by the hash of the .fl content.
+std::unordered_map<const ff8_file_container *, ff8_fl_index> fl_indexes;
 
 size_t get_fl_prefix_size()
 {
@@ -46,6 +69,57 @@ void ff8_fs_lang_string(char *data)
 	strncpy(data, ff8_externals.archive_path_prefix + 10, strlen(ff8_externals.archive_path_prefix) - 10 - 1);
 }
 
+bool direct_file_exists(const char *path)
+{
+	if (enable_direct_path_index) return directPathIndex.exists(path);
+
+	return fileExists(path);
+}
+
+std::string fl_index_key(const char *path)
+{
+	std::string ret(path);
+
+	for (char &c : ret) c = ::tolower((unsigned char)c);
+
+	return ret;
+}
+
+// built once per archive, the first time a path is searched in it, and again if its .fl changed
+const ff8_fl_index &get_fl_index(const ff8_file_container *file_container)
+{
+	ff8_fl_index &index = fl_indexes[file_container];
+	const ff8_file_fl *fl_infos = file_container->fl_infos;
+
+	XXH64_hash_t filenames_hash = fl_infos->filenames_data ? XXH3_64bits(fl_infos->filenames_data, fl_infos->filenames_data_size) : 0;
+
+	if (index.fl_infos == fl_infos && index.file_count == fl_infos->file_count && index.filenames_data == fl_infos->filenames_data
+		&& index.filenames_data_size == fl_infos->filenames_data_size && index.filenames_hash == filenames_hash) return index;
+
+	size_t prefix_size = get_fl_prefix_size();
+
+	index.fl_infos = fl_infos;
+	index.file_count = fl_infos->file_count;
+	index.filenames_data = fl_infos->filenames_data;
+	index.filenames_data_size = fl_infos->filenames_data_size;
+	index.filenames_hash = filenames_hash;
+	index.ids.clear();
+	index.ids.reserve(fl_infos->file_count);
+
+	for (int id = 0; id < fl_infos->file_count; ++id)
+	{
+		char *path = ff8_externals.fs_archive_get_fl_filepath(id, fl_infos);
+
+		if (strlen(path) < prefix_size) continue;
+
+		index.ids[fl_index_key(path + prefix_size)].push_back(id);
+	}
+
+	if (trace_all || trace_files) ffnx_trace("%s: indexed %d files\n", __func__, fl_infos->file_count);
+
+	return index;
+}
+
 bool set_direct_path(const char *fullpath, char *output, size_t output_size)
 {
 	if (strnicmp(fullpath + 2, ff8_externals.archive_path_prefix, strlen(ff8_externals.archive_path_prefix)) != 0)
@@ -68,7 +142,7 @@ bool check_direct_sub_archive_exists(const char *ext, const char *path_without_e
 
 	set_direct_path(archive_path, direct_path, sizeof(direct_path));
 
-	return fileExists(direct_path);
+	return direct_file_exists(direct_path);
 }
 
 void ff8_fs_archive_sub_archive_get_filename(const char *filename, char *dirname)
@@ -123,27 +197,46 @@ int ff8_fs_archive_search_filename2(const char *fullpath, ff8_file_fi_infos *fi_
 {
 	if (trace_all || trace_files) ffnx_trace("%s: Looking in archive for %s\n", __func__, fullpath);
 
+	size_t prefix_size = get_fl_prefix_size();
+	const std::vector<int> *ids = nullptr;
+
+	if (file_container != nullptr && file_container->fl_infos != nullptr && strlen(fullpath) >= prefix_size)
+	{
+		const ff8_fl_index &index = get_fl_index(file_container);
+		auto it = index.ids.find(fl_index_key(fullpath + prefix_size));
+
+		if (it != index.ids.end())
+		{
+			ids = &it->second;
+
+			// Same path in the same language. The game search walks the .fl in order and stops at the first
+			// case insensitive match of the full path, ids are in .fl order too, so this is the entry it would return.
+			for (int id : *ids)
+			{
+				if (!_stricmp(fullpath, ff8_externals.fs_archive_get_fl_filepath(id, file_container->fl_infos)))
+				{
+					*fi_infos_for_the_path = file_container->fi_infos[id];
+
+					return 1;
+				}
+			}
+		}
+	}
+
 	int ret = ff8_externals.ff8_fs_archive_search_filename2(fullpath, fi_infos_for_the_path, file_container);
 
 	if (ret != 1 && file_container != nullptr)
 	{
 		// Lookup without the language in the path
-		size_t prefix_size = get_fl_prefix_size();
-
 		if (trace_all || trace_files) ffnx_warning("%s: file not found, searching again with another language %s...\n", __func__, fullpath + prefix_size);
 
-		for (int id = 0; id < file_container->fl_infos->file_count; ++id)
+		if (ids != nullptr)
 		{
-			char *path = ff8_externals.fs_archive_get_fl_filepath(id, file_container->fl_infos);
-
-			if (!_stricmp(fullpath + prefix_size, path + prefix_size))
-			{
-				*fi_infos_for_the_path = file_container->fi_infos[id];
+			*fi_infos_for_the_path = file_container->fi_infos[ids->front()];
 
-				if (trace_all || trace_files) ffnx_trace("%s: found archive file in another language\n", __func__);
+			if (trace_all || trace_files) ffnx_trace("%s: found archive file in another language\n", __func__);
 
-				return 1;
-			}
+			return 1;
 		}
 	}
 
@@ -158,7 +251,7 @@ int ff8_fs_archive_search_filename_sub_archive(const char *fullpath, ff8_file_fi
 
 	set_direct_path(fullpath, direct_path, sizeof(direct_path));
 
-	if (fileExists(direct_path))
+	if (direct_file_exists(direct_path))
 	{
 		strncpy(next_direct_file, direct_path, sizeof(next_direct_file));
 
@@ -178,6 +271,8 @@ void ff8_fs_archive_free_file_container_sub_archive(ff8_file_container *file_con
 
 	*next_direct_file = '\0';
 
+	fl_indexes.erase(file_container);
+
 	return ff8_externals.free_file_container(file_container);
 }
 
@@ -193,6 +288,7 @@ uint8_t *ff8_fs_archive_malloc_source_data(size_t size, char *source_code_path,
 	if (trace_all || trace_files) ffnx_trace("%s size=%d\n", __func__, size);
 
 	last_compressed_size = size - 12;
+	last_source_size = size;
 
 	return (uint8_t *)common_externals.assert_malloc(size, source_code_path, line);
 }
@@ -201,6 +297,8 @@ uint8_t *ff8_fs_archive_malloc_target_data(size_t size, char *source_code_path,
 {
 	if (trace_all || trace_files) ffnx_trace("%s size=%d\n", __func__, size);
 
+	last_target_size = size;
+
 	if (last_compression_type == 2) // LZ4 compression
 	{
 		last_uncompressed_size = size;
@@ -215,6 +313,15 @@ void ff8_fs_archive_uncompress_data(const uint8_t *source_data, uint8_t *target_
 {
 	if (trace_all || trace_files) ffnx_trace("%s\n", __func__);
 
+	uint64_t cache_key = 0;
+
+	if (decompressionCache.isEnabled())
+	{
+		cache_key = decompressionCache.getKey(last_compression_type, source_data, last_source_size, last_target_size);
+
+		if (decompressionCache.load(cache_key, target_data, last_target_size)) return;
+	}
+
 	if (last_compression_type == 2) // LZ4 compression
 	{
 		if (trace_all || trace_files) ffnx_trace("%s LZ4 compression detected\n", __func__);
@@ -239,6 +346,8 @@ void ff8_fs_archive_uncompress_data(const uint8_t *source_data, uint8_t *target_
 	{
 		((void(*)(const uint8_t*, uint8_t*))ff8_externals.lzs_uncompress)(source_data, target_data);
 	}
+
+	if (decompressionCache.isEnabled()) decompressionCache.store(cache_key, last_compression_type, target_data, last_target_size);
 }
 
 bool ff8_attempt_redirection(const char *in, char *out, size_t size)
@@ -0,0 +1,116 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include <algorithm>
+#include <filesystem>
+
+#include "file_index.h"
+#include "log.h"
+#include "utils.h"
+
+FileIndex modPathIndex;
+FileIndex directPathIndex;
+
+// PRIVATE
+
+std::string FileIndex::normalize(const std::string& path)
+{
+	std::string ret;
+
+	ret.reserve(path.size());
+
+	for (char c : path)
+	{
+		if (c == '\\') c = '/';
+
+		// Collapse duplicate separators
+		if (c == '/' && !ret.empty() && ret.back() == '/') continue;
+
+		ret.push_back(::tolower((unsigned char)c));
+	}
+
+	if (!ret.empty() && ret.back() == '/') ret.pop_back();
+
+	return ret;
+}
+
+bool FileIndex::isIndexed(const std::string& normalizedPath)
+{
+	for (const auto& root : roots)
+	{
+		if (normalizedPath.size() > root.size() && starts_with(normalizedPath, root) && normalizedPath[root.size()] == '/') return true;
+	}
+
+	return false;
+}
+
+// PUBLIC
+
+void FileIndex::index(const std::string& dir)
+{
+	auto startTime = highResolutionNow();
+	size_t previousSize = files.size();
+	std::error_code ec;
+
+	std::string root = normalize(dir);
+
+	if (std::find(roots.begin(), roots.end(), root) != roots.end()) return;
+
+	// A missing root is still recorded, so every lookup inside it is answered as a miss
+	roots.push_back(root);
+
+	for (auto it = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+	{
+		std::string path;
+
+		// Names the game can't request are skipped, path::string() would throw on them
+		if (it->is_regular_file(ec) && pathToAnsi(it->path(), path)) files.insert(normalize(path));
+	}
+
+	ffnx_info("%s: indexed %u files in %s (%.2lf ms)\n", __func__, uint32_t(files.size() - previousSize), dir.c_str(), elapsedMicroseconds(startTime) / 1000.0);
+}
+
+void FileIndex::clear()
+{
+	roots.clear();
+	files.clear();
+}
+
+bool FileIndex::exists(const char* path)
+{
+	std::string normalizedPath = normalize(path);
+
+	if (!isIndexed(normalizedPath)) return fileExists(path);
+
+	savedCalls++;
+
+	return files.contains(normalizedPath);
+}
+
+size_t FileIndex::size()
+{
+	return files.size();
+}
+
+uint32_t FileIndex::getSavedCalls()
+{
+	return savedCalls;
+}
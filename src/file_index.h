@@ -0,0 +1,53 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+// In-memory snapshot of one or more directory trees, used to answer file existence checks without hitting the filesystem
+class FileIndex {
+private:
+	std::vector<std::string> roots;
+	std::unordered_set<std::string> files;
+
+	uint32_t savedCalls = 0;
+
+	static std::string normalize(const std::string& path);
+	bool isIndexed(const std::string& normalizedPath);
+
+public:
+	// Recursively add every regular file found in dir to the index
+	void index(const std::string& dir);
+	void clear();
+
+	// Paths outside of the indexed roots fall back to fileExists
+	bool exists(const char* path);
+
+	size_t size();
+	uint32_t getSavedCalls();
+};
+
+extern FileIndex modPathIndex;
+extern FileIndex directPathIndex;
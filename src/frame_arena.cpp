@@ -0,0 +1,86 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include <algorithm>
+
+#include "frame_arena.h"
+
+FrameArena::FrameArena(size_t blockSize) : blockSize(blockSize)
+{
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	while (true)
+	{
+		while (currentBlock < blocks.size())
+		{
+			Block& block = blocks[currentBlock];
+			size_t offset = (currentOffset + alignment - 1) & ~(alignment - 1);
+
+			if (offset + size <= block.size)
+			{
+				currentOffset = offset + size;
+
+				return block.data.get() + offset;
+			}
+
+			currentBlock++;
+			currentOffset = 0;
+		}
+
+		// Blocks are allocated lazily, an arena which is never used costs nothing
+		size_t newSize = std::max(blockSize, size + alignment);
+
+		blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[newSize]), newSize });
+	}
+}
+
+void FrameArena::reset()
+{
+	if (blocks.size() > 1)
+	{
+		blockSize = capacity();
+
+		blocks.clear();
+	}
+
+	currentBlock = 0;
+	currentOffset = 0;
+}
+
+void FrameArena::release()
+{
+	blocks.clear();
+	blocks.shrink_to_fit();
+
+	currentBlock = 0;
+	currentOffset = 0;
+}
+
+size_t FrameArena::capacity()
+{
+	size_t ret = 0;
+
+	for (const auto& block : blocks) ret += block.size;
+
+	return ret;
+}
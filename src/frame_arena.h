@@ -0,0 +1,60 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame.
+// Memory is handed out from large blocks and given back all at once by reset().
+class FrameArena {
+private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+	size_t blockSize;
+	size_t currentBlock = 0;
+	size_t currentOffset = 0;
+
+public:
+	explicit FrameArena(size_t blockSize);
+
+	void* allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+	template<typename T>
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// Invalidates every allocation. If the frame needed more than one block, they are merged so the next frame fits in one.
+	void reset();
+	void release();
+
+	size_t capacity();
+};
@@ -23,6 +23,7 @@
 #include "audio.h"
 #include "ff7/defs.h"
 #include "gamepad.h"
+#include "hext.h"
 #include "joystick.h"
 
 GameHacks gamehacks;
@@ -128,6 +129,26 @@ void GameHacks::skipMovies()
 	}
 }
 
+void GameHacks::reloadHextPatches()
+{
+	hextPatcher.reload();
+
+	show_popup_msg(TEXTCOLOR_LIGHT_BLUE, "Hext patches reloaded");
+
+	holdInput();
+}
+
+void GameHacks::reloadAudioFileIndex()
+{
+	if (!enable_audio_file_index) return;
+
+	nxAudioEngine.indexFiles();
+
+	show_popup_msg(TEXTCOLOR_LIGHT_BLUE, "Audio files reloaded");
+
+	holdInput();
+}
+
 void GameHacks::softReset()
 {
 	if (!ff8) ff7_do_reset = true;
@@ -165,6 +186,12 @@ void GameHacks::processKeyboardInput(UINT msg, WPARAM wParam, LPARAM lParam)
 			case 'B':
 				toggleBattleMode();
 				break;
+			case 'H':
+				reloadHextPatches();
+				break;
+			case 'F':
+				reloadAudioFileIndex();
+				break;
 			case 'M':
 				toggleMusicOnBattlePause();
 				break;
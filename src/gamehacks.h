@@ -52,6 +52,12 @@ private:
 	// SOFT RESET
 	void softReset();
 
+	// HEXT
+	void reloadHextPatches();
+
+	// AUDIO
+	void reloadAudioFileIndex();
+
 	// INPUT VALIDATION
 	void holdInput();
 	void drawnInput();
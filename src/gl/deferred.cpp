@@ -20,7 +20,12 @@
 //    GNU General Public License for more details.                          //
 /****************************************************************************/
 
+#include <algorithm>
+#include <vector>
+
 #include "../renderer.h"
+#include "../frame_arena.h"
+#include "../z_layers.h"
 
 #include "../gl.h"
 #include "../macro.h"
@@ -34,16 +39,38 @@
 
 uint32_t nodefer = false;
 
-#define DEFERRED_MAX 1024
-
-struct deferred_draw *deferred_draws;
+std::vector<deferred_draw> deferred_draws;
 uint32_t num_deferred;
 
-struct deferred_sorted_draw *deferred_sorted_draws;
+std::vector<deferred_sorted_draw> deferred_sorted_draws;
 uint32_t num_sorted_deferred;
 
+// vertex data of the queued draw calls, released all at once when each queue is drawn
+FrameArena deferred_arena(1024 * 1024);
+FrameArena sorted_deferred_arena(1024 * 1024);
+
 int lastBlitDrawCallIndex = -1;
 
+// every Z layer of the sorted queue is its own draw call, meshes which would go past this are drawn right away without sorting
+#define SORTED_DEFERRED_MAX 1024
+
+// get a cleared slot at the end of the queue, growing it if needed
+uint32_t gl_next_deferred()
+{
+	if (num_deferred == deferred_draws.size()) deferred_draws.emplace_back();
+	else deferred_draws[num_deferred] = {};
+
+	return num_deferred;
+}
+
+uint32_t gl_next_sorted_deferred()
+{
+	if (num_sorted_deferred == deferred_sorted_draws.size()) deferred_sorted_draws.emplace_back();
+	else deferred_sorted_draws[num_sorted_deferred] = {};
+
+	return num_sorted_deferred;
+}
+
 // save a draw call for later processing
 uint32_t gl_defer_draw(uint32_t primitivetype, uint32_t vertextype, struct nvertex* vertices, struct vector3<float>* normals, uint32_t vertexcount, WORD* indices, uint32_t count, struct boundingbox* boundingbox, struct light_data* lightdata, uint32_t clip, uint32_t mipmap)
 {
@@ -54,21 +81,13 @@ uint32_t gl_defer_draw(uint32_t primitivetype, uint32_t vertextype, struct nvert
 
 	if (trace_all) ffnx_trace("gl_defer_draw: call with primitivetype: %u - vertextype: %u - vertexcount: %u - count: %u - clip: %d - mipmap: %d\n", primitivetype, vertextype, vertexcount, count, clip, mipmap);
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_draw: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_draw: deferred draw queue overflow - num_deferred: %u - count: %u - DEFERRED_MAX: %u\n", num_deferred, count, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].count = count;
 	deferred_draws[defer].clip = clip;
@@ -76,8 +95,8 @@ uint32_t gl_defer_draw(uint32_t primitivetype, uint32_t vertextype, struct nvert
 	deferred_draws[defer].primitivetype = primitivetype;
 	deferred_draws[defer].vertextype = vertextype;
 	deferred_draws[defer].vertexcount = vertexcount;
-	deferred_draws[defer].indices = (WORD*)driver_malloc(sizeof(*indices) * count);
-	deferred_draws[defer].vertices = (nvertex*)driver_malloc(sizeof(*vertices) * vertexcount);
+	deferred_draws[defer].indices = deferred_arena.allocate<WORD>(count);
+	deferred_draws[defer].vertices = deferred_arena.allocate<nvertex>(vertexcount);
 	deferred_draws[defer].draw_call_type = DCT_DRAW;
 	if(enable_time_cycle)
 		deferred_draws[defer].is_time_filter_enabled = newRenderer.isTimeFilterEnabled();
@@ -90,7 +109,7 @@ uint32_t gl_defer_draw(uint32_t primitivetype, uint32_t vertextype, struct nvert
 
 	if (boundingbox)
 	{
-		deferred_draws[defer].boundingbox = (struct boundingbox*)driver_malloc(sizeof(struct boundingbox));
+		deferred_draws[defer].boundingbox = deferred_arena.allocate<struct boundingbox>(1);
 
 		deferred_draws[defer].boundingbox->min_x = boundingbox->min_x;
 		deferred_draws[defer].boundingbox->min_y = boundingbox->min_y;
@@ -102,7 +121,7 @@ uint32_t gl_defer_draw(uint32_t primitivetype, uint32_t vertextype, struct nvert
 	}
 	else // calculate AABB if no bounding box found
 	{
-		deferred_draws[defer].boundingbox = (struct boundingbox*)driver_malloc(sizeof(struct boundingbox));
+		deferred_draws[defer].boundingbox = deferred_arena.allocate<struct boundingbox>(1);
 
 		deferred_draws[defer].boundingbox->min_x = FLT_MAX;
 		deferred_draws[defer].boundingbox->min_y = FLT_MAX;
@@ -130,13 +149,13 @@ uint32_t gl_defer_draw(uint32_t primitivetype, uint32_t vertextype, struct nvert
 
 	if (normals)
 	{
-		deferred_draws[defer].normals = (vector3<float>*)driver_malloc(sizeof(*normals) * vertexcount);
+		deferred_draws[defer].normals = deferred_arena.allocate<vector3<float>>(vertexcount);
 		memcpy(deferred_draws[defer].normals, normals, sizeof(*normals) * vertexcount);
 	}
 
 	if(lightdata)
 	{
-		deferred_draws[defer].lightdata = (struct light_data*)driver_malloc(sizeof(struct light_data));
+		deferred_draws[defer].lightdata = deferred_arena.allocate<struct light_data>(1);
 		memcpy(deferred_draws[defer].lightdata, lightdata, sizeof(struct light_data));
 	}
 
@@ -156,21 +175,13 @@ uint32_t gl_defer_blit_framebuffer(struct texture_set *texture_set, struct tex_h
 
 	if (trace_all) ffnx_trace("gl_defer_blit_framebuffer_buffer");
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_draw: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_blit_framebuffer_buffer: deferred draw queue overflow - num_deferred: %u - count: 1 - DEFERRED_MAX: %u\n", num_deferred, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].fb_texture_set = texture_set;
 	deferred_draws[defer].fb_tex_header = tex_header;
@@ -193,21 +204,13 @@ uint32_t gl_defer_clear_buffer(uint32_t clear_color, uint32_t clear_depth, struc
 
 	if (trace_all) ffnx_trace("gl_defer_clear_buffer");
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_clear_buffer: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_clear_buffer: deferred draw queue overflow - num_deferred: %u - count: 1 - DEFERRED_MAX: %u\n", num_deferred, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].clear_color = clear_color;
 	deferred_draws[defer].clear_depth = clear_depth;
@@ -230,21 +233,13 @@ uint32_t gl_defer_yuv_frame(uint32_t buffer_index)
 
 	if (trace_all) ffnx_trace("gl_defer_yuv_frame");
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_yuv_frame: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_yuv_frame: deferred draw queue overflow - num_deferred: %u - count: 1 - DEFERRED_MAX: %u\n", num_deferred, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].movie_buffer_index = buffer_index;
 	deferred_draws[defer].draw_call_type = DCT_DRAW_MOVIE;
@@ -265,21 +260,13 @@ uint32_t gl_defer_zoom()
 
 	if (trace_all) ffnx_trace("gl_defer_zoom");
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_zoom: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_zoom: deferred draw queue overflow - num_deferred: %u - count: 1 - DEFERRED_MAX: %u\n", num_deferred, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].draw_call_type = DCT_ZOOM;
 
@@ -299,21 +286,13 @@ uint32_t gl_defer_world_external_mesh()
 
 	if (trace_all) ffnx_trace("gl_defer_world_external_mesh");
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_world_external_mesh: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_world_external_mesh: deferred draw queue overflow - num_deferred: %u - count: 1 - DEFERRED_MAX: %u\n", num_deferred, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].draw_call_type = DCT_WORLD_EXTERNAL_MESH;
 	deferred_draws[defer].is_time_filter_enabled = newRenderer.isTimeFilterEnabled();
@@ -335,21 +314,13 @@ uint32_t gl_defer_cloud_external_mesh()
 
 	if (trace_all) ffnx_trace("gl_defer_cloud_external_mesh");
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_cloud_external_mesh: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_cloud_external_mesh: deferred draw queue overflow - num_deferred: %u - count: 1 - DEFERRED_MAX: %u\n", num_deferred, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].draw_call_type = DCT_CLOUD_EXTERNAL_MESH;
 	deferred_draws[defer].is_time_filter_enabled = newRenderer.isTimeFilterEnabled();
@@ -371,21 +342,13 @@ uint32_t gl_defer_battle_depth_clear()
 
 	if (trace_all) ffnx_trace("gl_defer_battle_depth_clear");
 
-	if (!deferred_draws) deferred_draws = (deferred_draw*)driver_calloc(sizeof(*deferred_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_battle_depth_clear: nodefer true\n");
 		return false;
 	}
 
-	if (num_deferred + 1 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_battle_depth_clear: deferred draw queue overflow - num_deferred: %u - count: 1 - DEFERRED_MAX: %u\n", num_deferred, DEFERRED_MAX);
-		return false;
-	}
-
-	uint32_t defer = num_deferred;
+	uint32_t defer = gl_next_deferred();
 
 	deferred_draws[defer].draw_call_type = DCT_BATTLE_DEPTH_CLEAR;
 
@@ -400,15 +363,11 @@ uint32_t gl_defer_battle_depth_clear()
 uint32_t gl_defer_sorted_draw(uint32_t primitivetype, uint32_t vertextype, struct nvertex *vertices, uint32_t vertexcount, WORD *indices, uint32_t count, uint32_t clip, uint32_t mipmap, uint32_t force_defer)
 {
 	uint32_t tri;
+	uint32_t tri_count = count / 3;
 	uint32_t mode = getmode_cached()->driver_mode;
-	uint32_t *tri_deferred;
-	float *tri_z;
-	uint32_t defer_index = 0;
 
 	if (trace_all) ffnx_trace("gl_defer_sorted_draw: call with primitivetype: %u - vertextype: %u - vertexcount: %u - count: %u - clip: %d - mipmap: %d\n", primitivetype, vertextype, vertexcount, count, clip, mipmap);
 
-	if(!deferred_sorted_draws) deferred_sorted_draws = (deferred_sorted_draw*)driver_calloc(sizeof(*deferred_sorted_draws), DEFERRED_MAX);
-
 	// global disable
 	if (nodefer) {
 		if (trace_all) ffnx_trace("gl_defer_sorted_draw: nodefer true\n");
@@ -474,17 +433,14 @@ uint32_t gl_defer_sorted_draw(uint32_t primitivetype, uint32_t vertextype, struc
 		}
 	}
 
-	if(num_sorted_deferred + count / 3 > DEFERRED_MAX)
-	{
-		if (trace_all) ffnx_trace("gl_defer_sorted_draw: deferred draw queue overflow - num_sorted_deferred: %u - count: %u - DEFERRED_MAX: %u\n", num_sorted_deferred, count, DEFERRED_MAX);
-		return false;
-	}
+	// scratch buffers, kept across calls to avoid allocating on every draw
+	static std::vector<float> tri_z;
+	static ZLayers z_layers;
 
-	tri_deferred = (uint32_t*)driver_calloc(sizeof(*tri_deferred), count / 3);
-	tri_z = (float*)driver_calloc(sizeof(*tri_z), count / 3);
+	tri_z.assign(tri_count, 0.0f);
 
 	// calculate screen space average Z coordinate for each triangle
-	for(tri = 0; tri < count / 3; tri++)
+	for(tri = 0; tri < tri_count; tri++)
 	{
 		uint32_t i;
 
@@ -507,15 +463,22 @@ uint32_t gl_defer_sorted_draw(uint32_t primitivetype, uint32_t vertextype, struc
 	}
 
 	// arrange triangles into layers based on Z coordinates calculated above
+	z_layers.build(tri_z.data(), tri_count);
+
+	if(num_sorted_deferred + z_layers.count() > SORTED_DEFERRED_MAX)
+	{
+		if (trace_all) ffnx_trace("gl_defer_sorted_draw: deferred draw queue overflow - num_sorted_deferred: %u - layers: %u - SORTED_DEFERRED_MAX: %u\n", num_sorted_deferred, z_layers.count(), SORTED_DEFERRED_MAX);
+		return false;
+	}
+
 	// each layer will be drawn separately
-	while(defer_index < count / 3)
+	for(uint32_t layer = 0; layer < z_layers.count(); layer++)
 	{
-		float z = tri_z[defer_index];
-		uint32_t tri_num = 0;
-		uint32_t defer = num_sorted_deferred;
+		float z = z_layers.getZ(layer);
+		uint32_t tri_num = z_layers.getSize(layer);
+		uint32_t defer = gl_next_sorted_deferred();
 		uint32_t vert_index = 0;
-
-		for(tri = 0; tri < count / 3; tri++) if(tri_z[tri] == z) tri_num++;
+		const uint32_t *tris = z_layers.getTris(layer);
 
 		deferred_sorted_draws[defer].deferred_draw.count = tri_num * 3;
 		deferred_sorted_draws[defer].deferred_draw.clip = clip;
@@ -523,8 +486,8 @@ uint32_t gl_defer_sorted_draw(uint32_t primitivetype, uint32_t vertextype, struc
 		deferred_sorted_draws[defer].deferred_draw.primitivetype = primitivetype;
 		deferred_sorted_draws[defer].deferred_draw.vertextype = vertextype;
 		deferred_sorted_draws[defer].deferred_draw.vertexcount = tri_num * 3;
-		deferred_sorted_draws[defer].deferred_draw.indices = (WORD*)driver_malloc(sizeof(*indices) * tri_num * 3);
-		deferred_sorted_draws[defer].deferred_draw.vertices = (nvertex*)driver_malloc(sizeof(*vertices) * tri_num * 3);
+		deferred_sorted_draws[defer].deferred_draw.indices = sorted_deferred_arena.allocate<WORD>(tri_num * 3);
+		deferred_sorted_draws[defer].deferred_draw.vertices = sorted_deferred_arena.allocate<nvertex>(tri_num * 3);
 		gl_save_state(&deferred_sorted_draws[defer].deferred_draw.state);
 		deferred_sorted_draws[defer].drawn = false;
 		deferred_sorted_draws[defer].z = z;
@@ -532,33 +495,23 @@ uint32_t gl_defer_sorted_draw(uint32_t primitivetype, uint32_t vertextype, struc
 				deferred_sorted_draws[defer].deferred_draw.is_time_filter_enabled = newRenderer.isTimeFilterEnabled();
 		deferred_sorted_draws[defer].deferred_draw.is_fog_enabled = false;
 
-		for(tri = 0; tri < count / 3 && vert_index < tri_num * 3; tri++)
+		for(uint32_t i = 0; i < tri_num; i++)
 		{
-			if(tri_z[tri] == z)
-			{
-				memcpy(&deferred_sorted_draws[defer].deferred_draw.vertices[vert_index + 0], &vertices[indices[tri * 3 + 0]], sizeof(*vertices));
-				memcpy(&deferred_sorted_draws[defer].deferred_draw.vertices[vert_index + 1], &vertices[indices[tri * 3 + 1]], sizeof(*vertices));
-				memcpy(&deferred_sorted_draws[defer].deferred_draw.vertices[vert_index + 2], &vertices[indices[tri * 3 + 2]], sizeof(*vertices));
-				deferred_sorted_draws[defer].deferred_draw.indices[vert_index + 0] = vert_index + 0;
-				deferred_sorted_draws[defer].deferred_draw.indices[vert_index + 1] = vert_index + 1;
-				deferred_sorted_draws[defer].deferred_draw.indices[vert_index + 2] = vert_index + 2;
+			tri = tris[i];
 
-				vert_index += 3;
+			memcpy(&deferred_sorted_draws[defer].deferred_draw.vertices[vert_index + 0], &vertices[indices[tri * 3 + 0]], sizeof(*vertices));
+			memcpy(&deferred_sorted_draws[defer].deferred_draw.vertices[vert_index + 1], &vertices[indices[tri * 3 + 1]], sizeof(*vertices));
+			memcpy(&deferred_sorted_draws[defer].deferred_draw.vertices[vert_index + 2], &vertices[indices[tri * 3 + 2]], sizeof(*vertices));
+			deferred_sorted_draws[defer].deferred_draw.indices[vert_index + 0] = vert_index + 0;
+			deferred_sorted_draws[defer].deferred_draw.indices[vert_index + 1] = vert_index + 1;
+			deferred_sorted_draws[defer].deferred_draw.indices[vert_index + 2] = vert_index + 2;
 
-				tri_deferred[tri] = true;
-			}
+			vert_index += 3;
 		}
 
-		if(vert_index < tri_num * 3) ffnx_error("deferred draw z mismatch\n");
-
 		num_sorted_deferred++;
-
-		while(defer_index < count / 3 && tri_deferred[defer_index]) defer_index++;
 	}
 
-	driver_free(tri_deferred);
-	driver_free(tri_z);
-
 	if (trace_all) ffnx_trace("gl_defer_sorted_draw: return true\n");
 
 	return true;
@@ -654,20 +607,10 @@ void gl_draw_deferred(draw_field_shadow_callback shadow_callback)
 		);
 
 		++stats.deferred;
-
-		driver_free(deferred_draws[i].vertices);
-		deferred_draws[i].vertices = nullptr;
-		driver_free(deferred_draws[i].indices);
-		deferred_draws[i].indices = nullptr;
-		driver_free(deferred_draws[i].normals);
-		deferred_draws[i].normals = nullptr;
-		driver_free(deferred_draws[i].boundingbox);
-		deferred_draws[i].boundingbox = nullptr;
-		driver_free(deferred_draws[i].lightdata);
-		deferred_draws[i].lightdata = nullptr;
 	}
 
 	num_deferred = 0;
+	deferred_arena.reset();
 	lastBlitDrawCallIndex = -1;
 
 	nodefer = false;
@@ -743,23 +686,21 @@ void gl_draw_sorted_deferred()
 
 	stats.deferred += num_sorted_deferred;
 
-	while(true)
-	{
-		uint32_t i;
-		double z = -1.0;
-		uint32_t next = -1;
+	// farthest layers first, layers with the same Z keep the order in which they were queued
+	static std::vector<uint32_t> order;
 
-		for(i = 0; i < num_sorted_deferred; i++)
-		{
-			if(deferred_sorted_draws[i].z > z && !deferred_sorted_draws[i].drawn)
-			{
-				next = i;
-				z = deferred_sorted_draws[i].z;
-			}
-		}
+	order.clear();
+
+	for(uint32_t i = 0; i < num_sorted_deferred; i++)
+	{
+		// layers at or behind -1.0 were never picked by the previous search, keep skipping them
+		if(!deferred_sorted_draws[i].drawn && deferred_sorted_draws[i].z > -1.0) order.push_back(i);
+	}
 
-		if(next == -1) break;
+	std::stable_sort(order.begin(), order.end(), [](uint32_t a, uint32_t b) { return deferred_sorted_draws[a].z > deferred_sorted_draws[b].z; });
 
+	for(uint32_t next : order)
+	{
 		gl_load_state(&deferred_sorted_draws[next].deferred_draw.state);
 		internal_set_renderstate(V_DEPTHTEST, 1, 0);
 		internal_set_renderstate(V_DEPTHMASK, 1, 0);
@@ -781,12 +722,11 @@ void gl_draw_sorted_deferred()
 								  deferred_sorted_draws[next].deferred_draw.mipmap
 								  );
 
-		driver_free(deferred_sorted_draws[next].deferred_draw.vertices);
-		driver_free(deferred_sorted_draws[next].deferred_draw.indices);
 		deferred_sorted_draws[next].drawn = true;
 	}
 
 	num_sorted_deferred = 0;
+	sorted_deferred_arena.reset();
 
 	nodefer = false;
 
@@ -803,15 +743,11 @@ void gl_check_deferred(struct texture_set *texture_set)
 	{
 		if (deferred_draws[i].state.texture_set == texture_set)
 		{
-			driver_free(deferred_draws[i].vertices);
+			// the memory itself belongs to the frame arena
 			deferred_draws[i].vertices = nullptr;
-			driver_free(deferred_draws[i].indices);
 			deferred_draws[i].indices = nullptr;
-			driver_free(deferred_draws[i].normals);
 			deferred_draws[i].normals = nullptr;
-			driver_free(deferred_draws[i].boundingbox);
 			deferred_draws[i].boundingbox = nullptr;
-			driver_free(deferred_draws[i].lightdata);
 			deferred_draws[i].lightdata = nullptr;
 		}
 	}
@@ -820,8 +756,6 @@ void gl_check_deferred(struct texture_set *texture_set)
 	{
 		if(deferred_sorted_draws[i].deferred_draw.state.texture_set == texture_set)
 		{
-			driver_free(deferred_sorted_draws[i].deferred_draw.vertices);
-			driver_free(deferred_sorted_draws[i].deferred_draw.indices);
 			deferred_sorted_draws[i].drawn = true;
 		}
 	}
@@ -829,9 +763,14 @@ void gl_check_deferred(struct texture_set *texture_set)
 
 void gl_cleanup_deferred()
 {
-	driver_free(deferred_draws);
-	deferred_draws = nullptr;
-	driver_free(deferred_sorted_draws);
-	deferred_sorted_draws = nullptr;
+	deferred_draws.clear();
+	deferred_draws.shrink_to_fit();
+	num_deferred = 0;
+	deferred_sorted_draws.clear();
+	deferred_sorted_draws.shrink_to_fit();
+	num_sorted_deferred = 0;
+
+	deferred_arena.release();
+	sorted_deferred_arena.release();
 }
 
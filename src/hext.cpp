@@ -31,40 +31,43 @@ Hext hextPatcher;
 
 // PRIVATE
 
-int Hext::getAddress(std::string token)
+Hext::Address Hext::getAddress(std::string token)
 {
-    int ret;
+    Address ret;
 
     std::vector<std::string> sparts = split(token, "[+-]+");
-    std::vector<int> iparts;
 
     if (ends_with(sparts[0], "^"))
     {
-        std::stringstream ss;
-        int *ptr = (int*)(std::stoi(sparts[0].substr(0, sparts[0].length() - 1), nullptr, 16) + inGlobalOffset);
-        ss << std::hex << *ptr;
-        sparts[0] = ss.str();
+        ret.indirect = true;
+        sparts[0] = sparts[0].substr(0, sparts[0].length() - 1);
     }
 
-    for (auto &part : sparts)
-    {
-        iparts.push_back(
-            std::stoi(part, nullptr, 16)
-        );
-    }
-
-    ret = iparts[0];
+    ret.base = std::stoi(sparts[0], nullptr, 16);
 
     if (contains(token, "+"))
     {
-        ret += iparts[1];
+        ret.offset = std::stoi(sparts[1], nullptr, 16);
     }
     else if (contains(token, "-"))
     {
-        ret -= iparts[1];
+        ret.offset = -std::stoi(sparts[1], nullptr, 16);
+    }
+
+    return ret;
+}
+
+int Hext::resolveAddress(const Address &address)
+{
+    int ret = address.base;
+
+    if (address.indirect)
+    {
+        int *ptr = (int*)(address.base + inGlobalOffset);
+        ret = *ptr;
     }
 
-    return ret + inGlobalOffset;
+    return ret + address.offset + inGlobalOffset;
 }
 
 std::vector<char> Hext::getBytes(std::string token)
@@ -104,20 +107,21 @@ bool Hext::hasCheckpoint(std::string token)
     return false;
 }
 
-bool Hext::parseCheckpoint(std::string token, std::string checkpoint)
+bool Hext::parseCheckpoint(std::string token, std::string &checkpoint)
 {
     if (starts_with(token, "!"))
     {
-        if (contains(token, checkpoint))
-        {
-            return true;
-        }
+        checkpoint = token.substr(1);
+
+        trim(checkpoint);
+
+        return true;
     }
 
     return false;
 }
 
-bool Hext::parseCommands(std::string token)
+bool Hext::parseCommands(std::string token, Patch &patch)
 {
     if (starts_with(token, "<<"))
     {
@@ -125,7 +129,7 @@ bool Hext::parseCommands(std::string token)
 
         trim(token);
 
-        ffnx_trace("%s\n", token.data());
+        patch.operations.push_back({ OperationType::COMMAND, token });
 
         return true;
     }
@@ -154,17 +158,21 @@ bool Hext::parseComment(std::string token)
     return false;
 }
 
-bool Hext::parseGlobalOffset(std::string token)
+bool Hext::parseGlobalOffset(std::string token, Patch &patch)
 {
+    Operation operation = { OperationType::GLOBAL_OFFSET };
+
     if (starts_with(token, "+"))
     {
-        inGlobalOffset = std::stoi(token.substr(1), nullptr, 16);
+        operation.value = std::stoi(token.substr(1), nullptr, 16);
+        patch.operations.push_back(operation);
 
         return true;
     }
     else if (starts_with(token, "-"))
     {
-        inGlobalOffset = -std::stoi(token.substr(1), nullptr, 16);
+        operation.value = -std::stoi(token.substr(1), nullptr, 16);
+        patch.operations.push_back(operation);
 
         return true;
     }
@@ -172,17 +180,17 @@ bool Hext::parseGlobalOffset(std::string token)
     return false;
 }
 
-bool Hext::parseMemoryPermission(std::string token)
+bool Hext::parseMemoryPermission(std::string token, Patch &patch)
 {
     if (contains(token, ":"))
     {
-        DWORD dummy;
+        Operation operation = { OperationType::MEMORY_PERMISSION };
 
         std::vector<std::string> parts = split(token, "[:]+");
-        int addr = getAddress(parts[0]);
-        int length = std::stoi(parts[1], nullptr, 16);
+        operation.address = getAddress(parts[0]);
+        operation.value = std::stoi(parts[1], nullptr, 16);
 
-        VirtualProtect((LPVOID)addr, length, PAGE_EXECUTE_READWRITE, &dummy);
+        patch.operations.push_back(operation);
 
         return true;
     }
@@ -190,17 +198,17 @@ bool Hext::parseMemoryPermission(std::string token)
     return false;
 }
 
-bool Hext::parseMemoryPatch(std::string token)
+bool Hext::parseMemoryPatch(std::string token, Patch &patch)
 {
     if (contains(token, "="))
     {
-        DWORD dummy;
+        Operation operation = { OperationType::MEMORY_PATCH };
 
         std::vector<std::string> parts = split(token, "[=]+");
-        int addr = getAddress(parts[0]);
-        std::vector<char> bytes = getBytes(parts[1]);
+        operation.address = getAddress(parts[0]);
+        operation.bytes = getBytes(parts[1]);
 
-        memcpy_code(addr, bytes.data(), bytes.size());
+        patch.operations.push_back(operation);
 
         return true;
     }
@@ -208,115 +216,152 @@ bool Hext::parseMemoryPatch(std::string token)
     return false;
 }
 
-// PUBLIC
-
-void Hext::apply(std::string filename)
+void Hext::compile(std::string filename)
 {
     std::string line;
     std::ifstream ifs(filename);
 
-    while (std::getline(ifs, line))
+    Patch patch;
+    std::string checkpoint;
+    bool isFirstInstruction = true;
+    uint32_t lineNumber = 0;
+
+    patch.filename = filename;
+    isMultilineComment = false;
+
+    try
     {
-        if (line.empty()) continue;
+        while (std::getline(ifs, line))
+        {
+            lineNumber++;
 
-        // Check if delayed, if so it should not be applied
-        if (hasCheckpoint(line)) {
-            ifs.close();
-            return;
-        }
+            if (line.empty()) continue;
+
+            // Check if is a comment
+            if (parseComment(line)) continue;
+
+            // A checkpoint on the first instruction makes the whole file a delayed patch.
+            // Otherwise the patch ends at the first checkpoint.
+            if (hasCheckpoint(line))
+            {
+                if (isFirstInstruction) parseCheckpoint(line, checkpoint);
+                else if (checkpoint.empty()) break;
+
+                isFirstInstruction = false;
+
+                continue;
+            }
+
+            isFirstInstruction = false;
 
-        // Check if is a comment
-        if (parseComment(line)) continue;
+            // Check if is a command
+            if (parseCommands(line, patch)) continue;
 
-        // Check if is a command
-        if (parseCommands(line)) continue;
+            // Check if is a global offset
+            if (parseGlobalOffset(line, patch)) continue;
 
-        // Check if is a global offset
-        if (parseGlobalOffset(line)) continue;
+            // Check if is a memory permission range
+            if (parseMemoryPermission(line, patch)) continue;
 
-        // Check if is a memory permission range
-        if (parseMemoryPermission(line)) continue;
+            // Check if is a memory patch instruction
+            if (parseMemoryPatch(line, patch)) continue;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        ffnx_error("Hext: could not parse %s at line %u (%s), the patch will not be applied\n", filename.c_str(), lineNumber, e.what());
 
-        // Check if is a memory patch instruction
-        if (parseMemoryPatch(line)) continue;
+        return;
     }
 
     ifs.close();
 
-    ffnx_trace("Applied Hext patch: %s\n", filename.c_str());
+    if (checkpoint.empty()) patches.push_back(std::move(patch));
+    else delayedPatches[checkpoint].push_back(std::move(patch));
 }
 
-void Hext::applyDelayed(std::string filename, std::string checkpoint)
+void Hext::load()
 {
-    std::string line;
-    std::ifstream ifs(filename);
-
-    bool matchCheckpoint = false;
+    patches.clear();
+    delayedPatches.clear();
 
-    while (std::getline(ifs, line))
+    if (fileExists(hext_patching_path.c_str()))
     {
-        if (line.empty()) continue;
-
-        // Check if is a comment
-        if (parseComment(line)) continue;
-
-        // Check if is a delayed patch.
-        if (parseCheckpoint(line, checkpoint)) {
-            matchCheckpoint = true;
-
-            continue;
+        for (const auto& entry : std::filesystem::directory_iterator(hext_patching_path))
+        {
+            if (entry.is_regular_file()) {
+                compile(entry.path().string());
+            }
         }
+    }
 
-        if (matchCheckpoint)
-        {
-            // Check if is a command
-            if (parseCommands(line)) continue;
+    isLoaded = true;
 
-            // Check if is a global offset
-            if (parseGlobalOffset(line)) continue;
+    ffnx_trace("Hext: loaded %u patches and %u checkpoints from %s\n", patches.size(), delayedPatches.size(), hext_patching_path.c_str());
+}
 
-            // Check if is a memory permission range
-            if (parseMemoryPermission(line)) continue;
+void Hext::run(const Patch &patch)
+{
+    DWORD dummy;
 
-            // Check if is a memory patch instruction
-            if (parseMemoryPatch(line)) continue;
-        }
-        else
+    inGlobalOffset = 0;
+
+    for (const Operation &operation : patch.operations)
+    {
+        switch (operation.type)
         {
+        case OperationType::COMMAND:
+            ffnx_trace("%s\n", operation.text.data());
+            break;
+        case OperationType::GLOBAL_OFFSET:
+            inGlobalOffset = operation.value;
+            break;
+        case OperationType::MEMORY_PERMISSION:
+            VirtualProtect((LPVOID)resolveAddress(operation.address), operation.value, PAGE_EXECUTE_READWRITE, &dummy);
+            break;
+        case OperationType::MEMORY_PATCH:
+            memcpy_code(resolveAddress(operation.address), (void*)operation.bytes.data(), operation.bytes.size());
             break;
         }
     }
 
-    ifs.close();
-
-    if (matchCheckpoint) ffnx_trace("Applied delayed Hext patch: %s\n", filename.c_str());
+    inGlobalOffset = 0;
 }
 
+// PUBLIC
+
 void Hext::applyAll(std::string checkpoint)
 {
-    if (fileExists(hext_patching_path.c_str()))
+    if (!isLoaded) load();
+
+    if (!checkpoint.empty())
     {
-        if (!checkpoint.empty())
+        auto it = delayedPatches.find(checkpoint);
+
+        if (it == delayedPatches.end()) return;
+
+        for (const Patch &patch : it->second)
         {
-            for (const auto& entry : std::filesystem::directory_iterator(hext_patching_path))
-            {
-                if (entry.is_regular_file()) {
-                    applyDelayed(entry.path().string(), checkpoint);
-                }
+            run(patch);
 
-                inGlobalOffset = 0;
-            }
+            ffnx_trace("Applied delayed Hext patch: %s\n", patch.filename.c_str());
         }
-        else
+    }
+    else
+    {
+        for (const Patch &patch : patches)
         {
-            for (const auto& entry : std::filesystem::directory_iterator(hext_patching_path))
-            {
-                if (entry.is_regular_file()) {
-                    apply(entry.path().string());
-                }
+            run(patch);
 
-                inGlobalOffset = 0;
-            }
+            ffnx_trace("Applied Hext patch: %s\n", patch.filename.c_str());
         }
     }
 }
+
+// parse the files again and apply the patches which do not wait for a checkpoint, delayed ones will be applied on their next checkpoint
+void Hext::reload()
+{
+    load();
+
+    applyAll();
+}
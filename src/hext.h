@@ -31,28 +31,69 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Hext {
 private:
-	int inGlobalOffset;
+	enum class OperationType
+	{
+		COMMAND,
+		GLOBAL_OFFSET,
+		MEMORY_PERMISSION,
+		MEMORY_PATCH
+	};
+
+	// addresses ending with ^ are pointers, they are read only when the patch is applied
+	struct Address
+	{
+		int base = 0;
+		int offset = 0;
+		bool indirect = false;
+	};
+
+	struct Operation
+	{
+		OperationType type;
+		std::string text;
+		Address address;
+		int value = 0;
+		std::vector<char> bytes;
+	};
+
+	struct Patch
+	{
+		std::string filename;
+		std::vector<Operation> operations;
+	};
+
+	int inGlobalOffset = 0;
 	bool isMultilineComment = false;
+	bool isLoaded = false;
+
+	// files are parsed once, patches applied on startup and delayed patches keyed by their checkpoint
+	std::vector<Patch> patches;
+	std::unordered_map<std::string, std::vector<Patch>> delayedPatches;
 
-	int getAddress(std::string token);
+	Address getAddress(std::string token);
+	int resolveAddress(const Address &address);
 	std::vector<char> getBytes(std::string token);
 
 	bool hasCheckpoint(std::string token);
-	bool parseCheckpoint(std::string token, std::string checkpoint);
-	bool parseCommands(std::string token);
+	bool parseCheckpoint(std::string token, std::string &checkpoint);
+	bool parseCommands(std::string token, Patch &patch);
 	bool parseComment(std::string token);
-	bool parseGlobalOffset(std::string token);
-	bool parseMemoryPermission(std::string token);
-	bool parseMemoryPatch(std::string token);
+	bool parseGlobalOffset(std::string token, Patch &patch);
+	bool parseMemoryPermission(std::string token, Patch &patch);
+	bool parseMemoryPatch(std::string token, Patch &patch);
+
+	void compile(std::string filename);
+	void load();
+	void run(const Patch &patch);
 
 public:
-	void apply(std::string filename);
-	void applyDelayed(std::string filename, std::string checkpoint);
 	void applyAll(std::string checkpoint = std::string());
+	void reload();
 };
 
 extern Hext hextPatcher;
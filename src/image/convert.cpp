@@ -0,0 +1,251 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include "convert.h"
+#include "../macro.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CONVERT_SSE2
+#endif
+
+// convert a single 8-bit paletted pixel to 32-bit BGRA format
+_inline uint32_t pal2bgra(uint32_t pixel, uint32_t *palette, uint32_t palette_offset, uint32_t color_key, uint32_t reference_alpha)
+{
+	if(color_key && pixel == 0) return 0;
+
+	else
+	{
+		uint32_t color = palette[palette_offset + pixel];
+		// FF7 uses a form of alpha keying to emulate PSX blending
+		if(BGRA_A(color) == 0xFE) color = (color & 0xFFFFFF) | reference_alpha;
+		return color;
+	}
+}
+
+#define CONVERT_LUT_SIZE 256
+
+// per-channel conversion tables for RGB(A) formats, values are already shifted to their BGRA position
+struct convert_luts
+{
+	uint32_t blue[CONVERT_LUT_SIZE];
+	uint32_t green[CONVERT_LUT_SIZE];
+	uint32_t red[CONVERT_LUT_SIZE];
+	uint32_t alpha[CONVERT_LUT_SIZE];
+	uint32_t inverted_alpha[CONVERT_LUT_SIZE];
+};
+
+// returns false if the channel is too wide to be tabulated
+bool build_channel_lut(uint32_t *lut, uint32_t mask, uint32_t shift, uint32_t max, uint32_t position, uint32_t empty, uint32_t invert)
+{
+	uint32_t range = mask >> shift;
+
+	if(range >= CONVERT_LUT_SIZE) return false;
+
+	for(uint32_t v = 0; v <= range; v++)
+	{
+		if(max == 0) lut[v] = empty << position;
+		else if(invert) lut[v] = (255 - ((v * 255) / max)) << position;
+		else lut[v] = ((v * 255) / max) << position;
+	}
+
+	return true;
+}
+
+bool build_convert_luts(struct texture_format *tex_format, struct convert_luts *luts)
+{
+	return build_channel_lut(luts->blue, tex_format->blue_mask, tex_format->blue_shift, tex_format->blue_max, 0, 0, false)
+		&& build_channel_lut(luts->green, tex_format->green_mask, tex_format->green_shift, tex_format->green_max, 8, 0, false)
+		&& build_channel_lut(luts->red, tex_format->red_mask, tex_format->red_shift, tex_format->red_max, 16, 0, false)
+		&& build_channel_lut(luts->alpha, tex_format->alpha_mask, tex_format->alpha_shift, tex_format->alpha_max, 24, 255, false)
+		&& build_channel_lut(luts->inverted_alpha, tex_format->alpha_mask, tex_format->alpha_shift, tex_format->alpha_max, 24, 255, true);
+}
+
+// plain 8 bits per channel BGR(A) layout, color channels can be copied as they are
+bool is_bgra8_format(struct texture_format *tex_format)
+{
+	return tex_format->blue_mask == 0xFF && tex_format->blue_shift == 0 && tex_format->blue_max == 255
+		&& tex_format->green_mask == 0xFF00 && tex_format->green_shift == 8 && tex_format->green_max == 255
+		&& tex_format->red_mask == 0xFF0000 && tex_format->red_shift == 16 && tex_format->red_max == 255
+		&& (tex_format->alpha_max == 0 || (tex_format->alpha_mask == 0xFF000000 && tex_format->alpha_shift == 24 && tex_format->alpha_max == 255));
+}
+
+template<uint32_t bytesperpixel>
+_inline uint32_t read_pixel(const unsigned char *image_data)
+{
+	if constexpr (bytesperpixel == 2) return *((WORD *)image_data);
+	else if constexpr (bytesperpixel == 3) return image_data[0] | image_data[1] << 8 | image_data[2] << 16;
+	else return *((uint32_t *)image_data);
+}
+
+// PSX style mask bit
+_inline bool is_color_keyed(uint32_t pixel, uint32_t color_key, uint32_t alpha_mask)
+{
+	return (color_key == 1 && (pixel & ~alpha_mask) == 0) || (color_key == 3 && pixel == 0);
+}
+
+bool convert_paletted(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, uint32_t color_key, uint32_t palette_offset, uint32_t reference_alpha)
+{
+	uint32_t palette[256];
+	uint32_t entries = std::min(tex_format->palette_size, 256u);
+
+	// resolve color keying and alpha keying once per palette entry instead of once per pixel
+	for(uint32_t i = 0; i < entries; i++) palette[i] = pal2bgra(i, tex_format->palette_data, palette_offset, color_key, reference_alpha);
+
+	for(uint32_t c = 0; c < pixels; c++)
+	{
+		uint32_t index = image_data[c];
+
+		if(index < entries) converted_image_data[c] = palette[index];
+		else if(index == tex_format->palette_size) converted_image_data[c] = pal2bgra(index, tex_format->palette_data, palette_offset, color_key, reference_alpha);
+		else return false;
+	}
+
+	return true;
+}
+
+template<uint32_t bytesperpixel>
+void convert_bgra8(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, uint32_t invert_alpha, uint32_t color_key)
+{
+	uint32_t alpha_or = tex_format->alpha_max == 0 ? 0xFF000000 : 0;
+	uint32_t keep_mask = tex_format->alpha_max == 0 ? 0xFFFFFF : 0xFFFFFFFF;
+	uint32_t alpha_xor = invert_alpha && tex_format->alpha_max > 0 ? 0xFF000000 : 0;
+	uint32_t c = 0;
+
+#ifdef CONVERT_SSE2
+	if constexpr (bytesperpixel == 4)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i keep = _mm_set1_epi32((int)keep_mask);
+		const __m128i alpha = _mm_set1_epi32((int)alpha_or);
+		const __m128i invert = _mm_set1_epi32((int)alpha_xor);
+		const __m128i no_invert = _mm_set1_epi32(0x8000);
+		const __m128i key_mask = _mm_set1_epi32((int)(color_key == 1 ? ~tex_format->alpha_mask : 0xFFFFFFFF));
+		const bool keyed = color_key == 1 || color_key == 3;
+
+		for(; c + 4 <= pixels; c += 4)
+		{
+			__m128i pixel = _mm_loadu_si128((const __m128i *)(image_data + c * 4));
+			__m128i color = _mm_or_si128(_mm_and_si128(pixel, keep), alpha);
+
+			// special case to deal with poorly converted PSX images in FF7
+			color = _mm_xor_si128(color, _mm_andnot_si128(_mm_cmpeq_epi32(pixel, no_invert), invert));
+
+			if(keyed) color = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(pixel, key_mask), zero), color);
+
+			_mm_storeu_si128((__m128i *)(converted_image_data + c), color);
+		}
+	}
+#endif
+
+	for(; c < pixels; c++)
+	{
+		uint32_t pixel = read_pixel<bytesperpixel>(image_data + c * bytesperpixel);
+
+		if(is_color_keyed(pixel, color_key, tex_format->alpha_mask)) converted_image_data[c] = 0;
+		else converted_image_data[c] = ((pixel & keep_mask) | alpha_or) ^ (pixel != 0x8000 ? alpha_xor : 0);
+	}
+}
+
+template<uint32_t bytesperpixel>
+void convert_rgba_lut(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, const struct convert_luts *luts, uint32_t invert_alpha, uint32_t color_key)
+{
+	for(uint32_t c = 0; c < pixels; c++)
+	{
+		uint32_t pixel = read_pixel<bytesperpixel>(image_data + c * bytesperpixel);
+
+		if(is_color_keyed(pixel, color_key, tex_format->alpha_mask))
+		{
+			converted_image_data[c] = 0;
+			continue;
+		}
+
+		uint32_t alpha = (pixel & tex_format->alpha_mask) >> tex_format->alpha_shift;
+
+		converted_image_data[c] = luts->blue[(pixel & tex_format->blue_mask) >> tex_format->blue_shift]
+			| luts->green[(pixel & tex_format->green_mask) >> tex_format->green_shift]
+			| luts->red[(pixel & tex_format->red_mask) >> tex_format->red_shift]
+			| (invert_alpha && pixel != 0x8000 ? luts->inverted_alpha[alpha] : luts->alpha[alpha]);
+	}
+}
+
+void convert_rgba_generic(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, uint32_t invert_alpha, uint32_t color_key)
+{
+	uint32_t o = 0;
+
+	for(uint32_t c = 0; c < pixels; c++)
+	{
+		uint32_t pixel = 0;
+		uint32_t color = 0;
+
+		switch(tex_format->bytesperpixel)
+		{
+			// 16-bit RGB(A)
+			case 2:
+				pixel = read_pixel<2>(&image_data[o]);
+				break;
+			// 24-bit RGB
+			case 3:
+				pixel = read_pixel<3>(&image_data[o]);
+				break;
+			// 32-bit RGBA or RGBX
+			case 4:
+				pixel = read_pixel<4>(&image_data[o]);
+				break;
+		}
+
+		o += tex_format->bytesperpixel;
+
+		if(is_color_keyed(pixel, color_key, tex_format->alpha_mask))
+		{
+			converted_image_data[c] = 0;
+			continue;
+		}
+
+		// convert source data to 8 bits per channel
+		color = tex_format->blue_max > 0 ? ((((pixel & tex_format->blue_mask) >> tex_format->blue_shift) * 255) / tex_format->blue_max) : 0;
+		color |= (tex_format->green_max > 0 ? ((((pixel & tex_format->green_mask) >> tex_format->green_shift) * 255) / tex_format->green_max) : 0) << 8;
+		color |= (tex_format->red_max > 0 ? ((((pixel & tex_format->red_mask) >> tex_format->red_shift) * 255) / tex_format->red_max) : 0) << 16;
+
+		// special case to deal with poorly converted PSX images in FF7
+		if(invert_alpha && pixel != 0x8000) color |= (tex_format->alpha_max > 0 ? (255 - ((((pixel & tex_format->alpha_mask) >> tex_format->alpha_shift) * 255) / tex_format->alpha_max)) : 255) << 24;
+		else color |= (tex_format->alpha_max > 0 ? ((((pixel & tex_format->alpha_mask) >> tex_format->alpha_shift) * 255) / tex_format->alpha_max) : 255) << 24;
+
+		converted_image_data[c] = color;
+	}
+}
+
+void convert_rgba(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, uint32_t invert_alpha, uint32_t color_key)
+{
+	if(tex_format->bytesperpixel == 4 && is_bgra8_format(tex_format)) convert_bgra8<4>(image_data, converted_image_data, pixels, tex_format, invert_alpha, color_key);
+	else if(tex_format->bytesperpixel == 3 && is_bgra8_format(tex_format)) convert_bgra8<3>(image_data, converted_image_data, pixels, tex_format, invert_alpha, color_key);
+	else
+	{
+		struct convert_luts luts;
+
+		if(!build_convert_luts(tex_format, &luts)) convert_rgba_generic(image_data, converted_image_data, pixels, tex_format, invert_alpha, color_key);
+		else if(tex_format->bytesperpixel == 2) convert_rgba_lut<2>(image_data, converted_image_data, pixels, tex_format, &luts, invert_alpha, color_key);
+		else if(tex_format->bytesperpixel == 3) convert_rgba_lut<3>(image_data, converted_image_data, pixels, tex_format, &luts, invert_alpha, color_key);
+		else convert_rgba_lut<4>(image_data, converted_image_data, pixels, tex_format, &luts, invert_alpha, color_key);
+	}
+}
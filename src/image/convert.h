@@ -0,0 +1,34 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../common_imports.h"
+
+// Kernels used by convert_image_data to turn texture data into 32-bit BGRA
+// the kernel is picked once per call based on the texture format, every kernel gives the same output as the generic per-channel math
+
+// 8-bit paletted source data, returns false on the first index outside of the palette
+bool convert_paletted(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, uint32_t color_key, uint32_t palette_offset, uint32_t reference_alpha);
+// 16, 24 or 32-bit RGB(A) source data
+void convert_rgba(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, uint32_t invert_alpha, uint32_t color_key);
@@ -0,0 +1,326 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <sys/stat.h>
+#include <xxhash.h>
+
+#include "texture_cache.h"
+#include "image.h"
+
+#include "../renderer.h"
+#include "../log.h"
+#include "../utils.h"
+
+TextureCache textureCache;
+
+// PRIVATE
+
+void TextureCache::work()
+{
+	prune();
+
+	while (true)
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			cv.wait(lock, [this] { return !isRunning || !queue.empty(); });
+
+			if (!isRunning) return;
+
+			job = queue.front();
+			queue.pop_front();
+		}
+
+		auto startTime = highResolutionNow();
+
+		if (transcode(job))
+		{
+			transcodedCount++;
+
+			if (trace_all || trace_loaders) ffnx_trace("%s: transcoded %s to %s (%.2lf ms)\n", __func__, job.filename.c_str(), job.cachedFilename.c_str(), elapsedMicroseconds(startTime) / 1000.0);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			queued.erase(job.cachedFilename);
+		}
+	}
+}
+
+bool TextureCache::transcode(const Job& job)
+{
+	bimg::ImageMip mip;
+
+	if (!loadPng(job.filename.c_str(), mip, bimg::TextureFormat::BGRA8)) return false;
+
+	// Grayscale images are expanded without an alpha channel, leave them alone
+	if (mip.m_size != mip.m_width * mip.m_height * 4)
+	{
+		driver_free((void*)mip.m_data);
+
+		return false;
+	}
+
+	DirectX::Image image;
+	image.width = mip.m_width;
+	image.height = mip.m_height;
+	image.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+	image.rowPitch = mip.m_width * 4;
+	image.slicePitch = mip.m_size;
+	image.pixels = (uint8_t*)mip.m_data;
+
+	DirectX::ScratchImage mipChain, compressed;
+
+	// WIC needs COM to be initialized on the calling thread, the built-in filters don't
+	HRESULT hr = DirectX::GenerateMipMaps(image, DirectX::TEX_FILTER_FORCE_NON_WIC, 0, mipChain);
+
+	if (SUCCEEDED(hr)) hr = DirectX::Compress(mipChain.GetImages(), mipChain.GetImageCount(), mipChain.GetMetadata(), DXGI_FORMAT_BC7_UNORM, DirectX::TEX_COMPRESS_BC7_QUICK, DirectX::TEX_THRESHOLD_DEFAULT, compressed);
+
+	driver_free((void*)mip.m_data);
+
+	// Only complete files get the name looked up by load
+	std::string tmpFilename = job.cachedFilename + ".tmp";
+	std::error_code ec;
+
+	if (SUCCEEDED(hr)) hr = DirectX::SaveToDDSFile(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(), DirectX::DDS_FLAGS_NONE, std::filesystem::path(tmpFilename).wstring().c_str());
+
+	if (FAILED(hr))
+	{
+		ffnx_error("%s: could not transcode %s (%d)\n", __func__, job.filename.c_str(), HRESULT_CODE(hr));
+
+		std::filesystem::remove(tmpFilename, ec);
+
+		return false;
+	}
+
+	std::filesystem::rename(tmpFilename, job.cachedFilename, ec);
+
+	if (ec)
+	{
+		ffnx_error("%s: could not write %s\n", __func__, job.cachedFilename.c_str());
+
+		std::filesystem::remove(tmpFilename, ec);
+
+		return false;
+	}
+
+	return true;
+}
+
+// Remove leftovers of interrupted transcodings, then the least recently used copies until the cache fits in texture_cache_size
+void TextureCache::prune()
+{
+	struct Entry
+	{
+		std::filesystem::path path;
+		std::filesystem::file_time_type time;
+		uintmax_t size;
+	};
+
+	std::vector<Entry> entries;
+	uintmax_t totalSize = 0, maxSize = uintmax_t(texture_cache_size) * 1024 * 1024;
+	uint32_t removedCount = 0;
+	std::error_code ec;
+
+	for (auto it = std::filesystem::directory_iterator(path, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+	{
+		if (!it->is_regular_file(ec)) continue;
+
+		if (it->path().extension() == ".tmp")
+		{
+			if (std::filesystem::remove(it->path(), ec)) removedCount++;
+		}
+		else if (it->path().extension() == ".dds")
+		{
+			Entry entry{ it->path(), it->last_write_time(ec), it->file_size(ec) };
+
+			if (ec) continue;
+
+			entries.push_back(entry);
+			totalSize += entry.size;
+		}
+	}
+
+	if (maxSize > 0 && totalSize > maxSize)
+	{
+		// load refreshes the modification time of the copies it uses
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+
+		for (const Entry& entry : entries)
+		{
+			if (totalSize <= maxSize) break;
+
+			if (std::filesystem::remove(entry.path, ec))
+			{
+				totalSize -= entry.size;
+				removedCount++;
+			}
+		}
+	}
+
+	if (removedCount > 0) ffnx_info("Texture cache: removed %u stale files, %llu MB in use\n", removedCount, uint64_t(totalSize / (1024 * 1024)));
+}
+
+bool TextureCache::isCacheable(const char* filename)
+{
+	size_t len = strlen(filename);
+
+	return len > 4 && _stricmp(filename + len - 4, ".png") == 0;
+}
+
+std::string TextureCache::getCachedFilename(const char* filename)
+{
+	struct _stat64 st;
+
+	if (_stat64(filename, &st) != 0) return "";
+
+	// Reading and hashing the whole PNG would cost as much as decoding it, the path, size and modification time are enough to notice edits
+	struct
+	{
+		int64_t size;
+		int64_t mtime;
+	} stamp{ st.st_size, st.st_mtime };
+
+	XXH3_state_t* state = XXH3_createState();
+
+	XXH3_64bits_reset(state);
+	XXH3_64bits_update(state, filename, strlen(filename));
+	XXH3_64bits_update(state, &stamp, sizeof(stamp));
+
+	XXH64_hash_t hash = XXH3_64bits_digest(state);
+
+	XXH3_freeState(state);
+
+	char cachedFilename[sizeof(basedir) + 1024]{ 0 };
+
+	_snprintf(cachedFilename, sizeof(cachedFilename), "%s/%016llx.dds", path.c_str(), hash);
+
+	return cachedFilename;
+}
+
+// PUBLIC
+
+void TextureCache::init()
+{
+	if (!enable_texture_cache) return;
+
+	if (!(bgfx::getCaps()->formats[bgfx::TextureFormat::BC7] & BGFX_CAPS_FORMAT_TEXTURE_2D))
+	{
+		ffnx_warning("Texture cache disabled: BC7 textures are not supported by the current renderer\n");
+
+		return;
+	}
+
+	path = std::string(basedir) + "/" + texture_cache_path;
+
+	std::error_code ec;
+
+	std::filesystem::create_directories(path, ec);
+
+	if (ec)
+	{
+		ffnx_error("Texture cache disabled: could not create %s\n", path.c_str());
+
+		return;
+	}
+
+	isRunning = true;
+
+	worker = std::thread(&TextureCache::work, this);
+
+	ffnx_info("Texture cache enabled in %s\n", path.c_str());
+}
+
+void TextureCache::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		isRunning = false;
+	}
+
+	cv.notify_all();
+
+	if (worker.joinable()) worker.join();
+
+	queue.clear();
+	queued.clear();
+}
+
+bool TextureCache::isEnabled()
+{
+	return isRunning;
+}
+
+bimg::ImageContainer* TextureCache::load(bx::AllocatorI* allocator, const char* filename)
+{
+	if (!isRunning || !isCacheable(filename)) return nullptr;
+
+	std::string cachedFilename = getCachedFilename(filename);
+
+	if (cachedFilename.empty()) return nullptr;
+
+	if (fileExists(cachedFilename.c_str()))
+	{
+		bimg::ImageContainer* img = loadImageContainer(allocator, cachedFilename.c_str());
+
+		if (img != nullptr)
+		{
+			hitCount++;
+
+			// Mark the copy as recently used for prune
+			std::error_code ec;
+
+			std::filesystem::last_write_time(cachedFilename, std::filesystem::file_time_type::clock::now(), ec);
+
+			if (trace_all || trace_loaders) ffnx_trace("%s: using %s for %s\n", __func__, cachedFilename.c_str(), filename);
+
+			return img;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (queued.insert(cachedFilename).second) queue.push_back({ filename, cachedFilename });
+	}
+
+	cv.notify_one();
+
+	return nullptr;
+}
+
+uint32_t TextureCache::getHitCount()
+{
+	return hitCount;
+}
+
+uint32_t TextureCache::getTranscodedCount()
+{
+	return transcodedCount;
+}
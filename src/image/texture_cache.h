@@ -0,0 +1,77 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <unordered_set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <bx/allocator.h>
+#include <bimg/bimg.h>
+
+// Keeps block-compressed (BC7) copies of mod PNGs, keyed by the path, size and modification time of the source file.
+// Cached copies are used instead of the PNG on the next load, missing ones are transcoded in background.
+class TextureCache {
+private:
+	struct Job
+	{
+		std::string filename;
+		std::string cachedFilename;
+	};
+
+	std::string path;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool isRunning = false;
+
+	std::deque<Job> queue;
+	std::unordered_set<std::string> queued;
+
+	std::atomic<uint32_t> hitCount = 0;
+	std::atomic<uint32_t> transcodedCount = 0;
+
+	void work();
+	void prune();
+	bool transcode(const Job& job);
+	bool isCacheable(const char* filename);
+	std::string getCachedFilename(const char* filename);
+
+public:
+	void init();
+	void shutdown();
+
+	bool isEnabled();
+
+	// Returns the cached copy of filename, or queues its transcoding and returns nullptr. Thread safe.
+	bimg::ImageContainer* load(bx::AllocatorI* allocator, const char* filename);
+
+	uint32_t getHitCount();
+	uint32_t getTranscodedCount();
+};
+
+extern TextureCache textureCache;
@@ -0,0 +1,268 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include <algorithm>
+
+#include "texture_decoder.h"
+#include "image.h"
+#include "texture_cache.h"
+
+#include "../renderer.h"
+#include "../log.h"
+
+TextureDecoder textureDecoder;
+
+// PRIVATE
+
+void TextureDecoder::work()
+{
+	while (true)
+	{
+		std::shared_ptr<Job> job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			cv.wait(lock, [this] { return !isRunning || !queue.empty(); });
+
+			if (!isRunning) return;
+
+			job = queue.front();
+			queue.pop_front();
+		}
+
+		bimg::ImageContainer* img = decode(*job);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (job->cancelled)
+			{
+				if (img != nullptr) bimg::imageFree(img);
+				continue;
+			}
+
+			if (img == nullptr)
+			{
+				failedCount++;
+				forget(job);
+
+				ffnx_error("%s: failed to decode %s\n", __func__, job->filename.c_str());
+				continue;
+			}
+
+			lastLatencyMs = elapsedMicroseconds(job->queuedAt) / 1000.0;
+			totalLatencyMs += lastLatencyMs;
+			decodedCount++;
+
+			job->img = img;
+			done.push_back(job);
+		}
+	}
+}
+
+bimg::ImageContainer* TextureDecoder::decode(const Job& job)
+{
+	bimg::ImageContainer* cached = textureCache.load(&allocator, job.filename.c_str());
+
+	if (cached != nullptr) return cached;
+
+	if (job.useLibPng)
+	{
+		bimg::ImageMip mip;
+
+		if (!loadPng(job.filename.c_str(), mip)) return nullptr;
+
+		bimg::ImageContainer* img = bimg::imageAlloc(&allocator, mip.m_format, mip.m_width, mip.m_height, 0, 1, false, false, mip.m_data);
+
+		driver_free((void*)mip.m_data);
+
+		return img;
+	}
+
+	return loadImageContainer(&allocator, job.filename.c_str());
+}
+
+// Must be called with the mutex held
+void TextureDecoder::forget(const std::shared_ptr<Job>& job)
+{
+	std::erase(jobs, job);
+}
+
+// PUBLIC
+
+void TextureDecoder::init()
+{
+	if (!enable_async_texture_loading) return;
+
+	uint32_t threads = async_texture_loading_threads > 0 ? async_texture_loading_threads : 0;
+
+	// Leave one core to the game thread
+	if (threads == 0) threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	isRunning = true;
+
+	for (uint32_t idx = 0; idx < threads; idx++) workers.emplace_back(&TextureDecoder::work, this);
+
+	ffnx_info("Async texture loading enabled with %u decoder threads\n", threads);
+}
+
+void TextureDecoder::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		isRunning = false;
+	}
+
+	cv.notify_all();
+
+	for (auto& worker : workers) worker.join();
+
+	workers.clear();
+
+	for (auto& job : done) bimg::imageFree(job->img);
+
+	queue.clear();
+	done.clear();
+	jobs.clear();
+}
+
+bool TextureDecoder::isEnabled()
+{
+	return isRunning;
+}
+
+bool TextureDecoder::enqueue(const char* filename, bool useLibPng, bool isSrgb, const void* owner, uint32_t key, uint16_t slot, TextureDecoderCallback callback)
+{
+	if (!isRunning) return false;
+
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->filename = filename;
+	job->useLibPng = useLibPng;
+	job->isSrgb = isSrgb;
+	job->owner = owner;
+	job->key = key;
+	job->slot = slot;
+	job->callback = callback;
+	job->queuedAt = highResolutionNow();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		queue.push_back(job);
+		jobs.push_back(job);
+	}
+
+	cv.notify_one();
+
+	if (trace_all || trace_loaders) ffnx_trace("%s: queued %s (depth=%u)\n", __func__, filename, getQueueDepth());
+
+	return true;
+}
+
+bool TextureDecoder::isPending(const void* owner, uint32_t key, uint16_t slot)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (const auto& job : jobs)
+	{
+		if (job->owner == owner && job->key == key && job->slot == slot) return true;
+	}
+
+	return false;
+}
+
+void TextureDecoder::cancel(const void* owner)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto isOwned = [owner](const std::shared_ptr<Job>& job) { return job->owner == owner; };
+
+	for (auto& job : jobs)
+	{
+		if (!isOwned(job)) continue;
+
+		job->cancelled = true;
+
+		if (job->img != nullptr)
+		{
+			bimg::imageFree(job->img);
+			job->img = nullptr;
+		}
+	}
+
+	std::erase_if(queue, isOwned);
+	std::erase_if(done, isOwned);
+	std::erase_if(jobs, isOwned);
+}
+
+void TextureDecoder::update()
+{
+	std::deque<std::shared_ptr<Job>> ready;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (done.empty()) return;
+
+		ready.swap(done);
+
+		for (const auto& job : ready) forget(job);
+	}
+
+	for (const auto& job : ready)
+	{
+		uint32_t width = 0, height = 0, mipCount = 0;
+
+		// Ownership of the image container is passed to the renderer
+		bgfx::TextureHandle handle = newRenderer.createTextureHandle(job->img, job->filename.data(), &width, &height, &mipCount, job->isSrgb);
+		job->img = nullptr;
+
+		if (bgfx::isValid(handle))
+		{
+			if (trace_all || trace_loaders) ffnx_trace("%s: swapped in texture %u from %s\n", __func__, handle.idx, job->filename.c_str());
+
+			job->callback(handle.idx, width, height);
+		}
+	}
+}
+
+uint32_t TextureDecoder::getQueueDepth()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return jobs.size();
+}
+
+double TextureDecoder::getLastLatency()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return lastLatencyMs;
+}
+
+double TextureDecoder::getAverageLatency()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return decodedCount > 0 ? totalLatencyMs / decodedCount : 0.0;
+}
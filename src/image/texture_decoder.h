@@ -0,0 +1,99 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <bx/allocator.h>
+#include <bimg/bimg.h>
+
+#include "../utils.h"
+
+// Called on the game thread once the decoded image has been uploaded to the GPU
+typedef std::function<void(uint32_t texture, uint32_t width, uint32_t height)> TextureDecoderCallback;
+
+class TextureDecoder {
+private:
+	struct Job
+	{
+		std::string filename;
+		bool useLibPng = false;
+		bool isSrgb = true;
+		const void* owner = nullptr;
+		uint32_t key = 0;
+		uint16_t slot = 0;
+		TextureDecoderCallback callback;
+		bimg::ImageContainer* img = nullptr;
+		bool cancelled = false;
+		std::chrono::time_point<std::chrono::high_resolution_clock> queuedAt;
+	};
+
+	bx::DefaultAllocator allocator;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool isRunning = false;
+
+	// Jobs waiting for a worker
+	std::deque<std::shared_ptr<Job>> queue;
+	// Jobs decoded and waiting to be uploaded on the game thread
+	std::deque<std::shared_ptr<Job>> done;
+	// Every job not yet delivered, used for cancellation and pending lookups
+	std::vector<std::shared_ptr<Job>> jobs;
+
+	std::atomic<uint32_t> decodedCount = 0;
+	std::atomic<uint32_t> failedCount = 0;
+	double totalLatencyMs = 0.0;
+	double lastLatencyMs = 0.0;
+
+	void work();
+	bimg::ImageContainer* decode(const Job& job);
+	void forget(const std::shared_ptr<Job>& job);
+
+public:
+	void init();
+	void shutdown();
+
+	bool isEnabled();
+
+	bool enqueue(const char* filename, bool useLibPng, bool isSrgb, const void* owner, uint32_t key, uint16_t slot, TextureDecoderCallback callback);
+	bool isPending(const void* owner, uint32_t key, uint16_t slot = 0);
+	void cancel(const void* owner);
+
+	// Upload every decoded image and swap it in through its callback, must be called on the game thread
+	void update();
+
+	uint32_t getQueueDepth();
+	double getLastLatency();
+	double getAverageLatency();
+};
+
+extern TextureDecoder textureDecoder;
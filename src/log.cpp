@@ -29,8 +29,34 @@
 
 #define FFNX_DEBUG_BUFFER_SIZE 4096
 
+// 1 MB of log lines waiting to be written, in chunks of 128 bytes
+#define FFNX_LOG_CHUNK_SIZE 128
+#define FFNX_LOG_CHUNKS 8192
+// milliseconds to wait for the end of a line being queued before giving up
+#define FFNX_LOG_PUBLISH_TIMEOUT 100
+
 FILE *app_log;
 
+// Lines are queued by any thread and written by the log writer thread when enable_async_logging is set.
+// A line takes one or more consecutive chunks. Producers reserve them by moving log_ring_head forward,
+// then publish each chunk through its sequence number so the writer knows when it is complete.
+struct log_chunk
+{
+	std::atomic<uint32_t> sequence;
+	uint32_t length;
+	char data[FFNX_LOG_CHUNK_SIZE];
+};
+
+log_chunk *log_ring = nullptr;
+std::atomic<uint32_t> log_ring_head = 0;
+uint32_t log_ring_tail = 0;
+// set while a thread is writing the queued lines to the file
+std::atomic<bool> log_ring_writing = false;
+
+HANDLE log_writer_thread = nullptr;
+HANDLE log_writer_event = nullptr;
+std::atomic<bool> log_writer_sleeping = false;
+
 void open_applog(char *path)
 {
 	app_log = fopen(path, "wb");
@@ -38,6 +64,194 @@ void open_applog(char *path)
 	if(!app_log) MessageBoxA(gameHwnd, "Failed to open log file", "Error", 0);
 }
 
+// write every complete line in the ring, must only be called by the thread which set log_ring_writing
+bool write_log_ring()
+{
+	bool written = false;
+
+	while (true)
+	{
+		log_chunk &first = log_ring[log_ring_tail % FFNX_LOG_CHUNKS];
+
+		if (first.sequence.load(std::memory_order_acquire) != log_ring_tail + 1) break;
+
+		uint32_t length = first.length;
+		uint32_t chunks = (length + FFNX_LOG_CHUNK_SIZE - 1) / FFNX_LOG_CHUNK_SIZE;
+		bool complete = true;
+
+		// the producer may still be copying the end of the line, or may have been killed in the middle of it
+		for (uint32_t i = 1; complete && i < chunks; i++)
+		{
+			log_chunk &chunk = log_ring[(log_ring_tail + i) % FFNX_LOG_CHUNKS];
+			uint32_t start = GetTickCount();
+
+			while (chunk.sequence.load(std::memory_order_acquire) != log_ring_tail + i + 1)
+			{
+				if (GetTickCount() - start > FFNX_LOG_PUBLISH_TIMEOUT)
+				{
+					complete = false;
+					break;
+				}
+
+				SwitchToThread();
+			}
+		}
+
+		// leave the line in the ring, it will be written once complete
+		if (!complete) break;
+
+		for (uint32_t i = 0; i < chunks; i++)
+		{
+			log_chunk &chunk = log_ring[(log_ring_tail + i) % FFNX_LOG_CHUNKS];
+
+			uint32_t size = length - i * FFNX_LOG_CHUNK_SIZE;
+			if (size > FFNX_LOG_CHUNK_SIZE) size = FFNX_LOG_CHUNK_SIZE;
+
+			fwrite(chunk.data, 1, size, app_log);
+		}
+
+		// give the chunks back for the next round
+		for (uint32_t i = 0; i < chunks; i++)
+			log_ring[(log_ring_tail + i) % FFNX_LOG_CHUNKS].sequence.store(log_ring_tail + i + FFNX_LOG_CHUNKS, std::memory_order_release);
+
+		log_ring_tail += chunks;
+		written = true;
+	}
+
+	if (written) fflush(app_log);
+
+	return written;
+}
+
+DWORD WINAPI log_writer_loop(LPVOID)
+{
+	while (true)
+	{
+		bool written = false;
+
+		if (!log_ring_writing.exchange(true, std::memory_order_acquire))
+		{
+			written = write_log_ring();
+
+			log_ring_writing.store(false, std::memory_order_release);
+		}
+
+		if (!written)
+		{
+			// the timeout covers a line queued right before going to sleep
+			log_writer_sleeping.store(true);
+			WaitForSingleObject(log_writer_event, 10);
+			log_writer_sleeping.store(false);
+		}
+	}
+
+	return 0;
+}
+
+void push_log_ring(const char *str, uint32_t length)
+{
+	uint32_t chunks = (length + FFNX_LOG_CHUNK_SIZE - 1) / FFNX_LOG_CHUNK_SIZE;
+	uint32_t pos = log_ring_head.load(std::memory_order_relaxed);
+
+	if (length == 0) return;
+
+	while (true)
+	{
+		// chunks are given back in order, if the last one is free all of them are
+		uint32_t last = pos + chunks - 1;
+		int32_t diff = int32_t(log_ring[last % FFNX_LOG_CHUNKS].sequence.load(std::memory_order_acquire) - last);
+
+		if (diff == 0)
+		{
+			if (log_ring_head.compare_exchange_weak(pos, pos + chunks, std::memory_order_relaxed)) break;
+		}
+		else if (diff < 0)
+		{
+			// the ring is full, wait for the writer instead of losing lines
+			SetEvent(log_writer_event);
+			SwitchToThread();
+			pos = log_ring_head.load(std::memory_order_relaxed);
+		}
+		else pos = log_ring_head.load(std::memory_order_relaxed);
+	}
+
+	for (uint32_t i = 0; i < chunks; i++)
+	{
+		log_chunk &chunk = log_ring[(pos + i) % FFNX_LOG_CHUNKS];
+		uint32_t size = length - i * FFNX_LOG_CHUNK_SIZE;
+		if (size > FFNX_LOG_CHUNK_SIZE) size = FFNX_LOG_CHUNK_SIZE;
+
+		chunk.length = length;
+		memcpy(chunk.data, str + i * FFNX_LOG_CHUNK_SIZE, size);
+		chunk.sequence.store(pos + i + 1, std::memory_order_release);
+	}
+
+	if (log_writer_sleeping.load(std::memory_order_relaxed)) SetEvent(log_writer_event);
+}
+
+// from now on lines are written by a separate thread, the calling thread only copies them in the ring
+void start_applog_writer()
+{
+	if (log_ring || !app_log) return;
+
+	log_ring = new log_chunk[FFNX_LOG_CHUNKS];
+
+	for (uint32_t i = 0; i < FFNX_LOG_CHUNKS; i++) log_ring[i].sequence.store(i);
+
+	log_writer_event = CreateEventA(NULL, FALSE, FALSE, NULL);
+	log_writer_thread = CreateThread(NULL, 0, log_writer_loop, NULL, 0, NULL);
+
+	if (!log_writer_thread)
+	{
+		ffnx_error("Could not start the log writer thread, logging synchronously\n");
+
+		CloseHandle(log_writer_event);
+		delete[] log_ring;
+		log_ring = nullptr;
+	}
+}
+
+// write the queued lines from the calling thread, used when the writer thread may never run again (crash, exit)
+void flush_applog()
+{
+	if (!log_ring) return;
+
+	bool acquired = false;
+
+	// the writer thread may be in the middle of a write, or may have been killed during one when the process is exiting
+	for (uint32_t i = 0; i < 200 && !(acquired = !log_ring_writing.exchange(true, std::memory_order_acquire)); i++) Sleep(1);
+
+	// writing anyway would race with the writer thread on log_ring_tail
+	if (!acquired) return;
+
+	write_log_ring();
+
+	log_ring_writing.store(false, std::memory_order_release);
+}
+
+bool log_rate_allowed(log_rate_limit &limit)
+{
+	if (trace_rate_limit <= 0) return true;
+
+	uint32_t second = GetTickCount() / 1000;
+	uint32_t last_second = limit.second.load(std::memory_order_relaxed);
+
+	if (second != last_second && limit.second.compare_exchange_strong(last_second, second, std::memory_order_relaxed))
+	{
+		uint32_t suppressed = limit.suppressed.exchange(0, std::memory_order_relaxed);
+
+		limit.count.store(0, std::memory_order_relaxed);
+
+		if (suppressed > 0) debug_printf("TRACE", text_colors[TEXTCOLOR_GREEN], "trace_rate_limit suppressed %u lines like the next one\n", suppressed);
+	}
+
+	if (limit.count.fetch_add(1, std::memory_order_relaxed) < uint32_t(trace_rate_limit)) return true;
+
+	limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+
+	return false;
+}
+
 void plugin_trace(const char *fmt, ...)
 {
 	va_list args;
@@ -49,7 +263,8 @@ void plugin_trace(const char *fmt, ...)
 
 	va_end(args);
 
-	ffnx_trace("%s", tmp_str);
+	// all plugins share this call site, trace_rate_limit would drop the lines of one plugin because of another
+	debug_printf("TRACE", text_colors[TEXTCOLOR_GREEN], "%s", tmp_str);
 }
 
 void plugin_info(const char *fmt, ...)
@@ -100,6 +315,12 @@ void debug_print(const char *str)
 
 	sprintf(tmp_str, "[%08i] %s", frame_counter, str);
 
+	if (log_ring)
+	{
+		push_log_ring(tmp_str, strlen(tmp_str));
+		return;
+	}
+
 	fwrite(tmp_str, 1, strlen(tmp_str), app_log);
 	fflush(app_log);
 }
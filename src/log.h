@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <atomic>
+
 // Header include necessary due to macro dependencies
 #include "cfg.h"
 #include "common.h"
@@ -30,14 +32,26 @@
 #define ffnx_warning(x, ...) debug_printf("WARNING", text_colors[TEXTCOLOR_YELLOW], (x), ## __VA_ARGS__)
 #define ffnx_info(x, ...) debug_printf("INFO", text_colors[TEXTCOLOR_WHITE], (x), ## __VA_ARGS__)
 #define ffnx_dump(x, ...) debug_printf("DUMP", text_colors[TEXTCOLOR_PINK], (x), ## __VA_ARGS__)
-#define ffnx_trace(x, ...) debug_printf("TRACE", text_colors[TEXTCOLOR_GREEN], (x), ## __VA_ARGS__)
+#define ffnx_trace(x, ...) (log_rate_allowed([]() -> log_rate_limit& { static log_rate_limit limit; return limit; }()) ? debug_printf("TRACE", text_colors[TEXTCOLOR_GREEN], (x), ## __VA_ARGS__) : (void)0)
 #define ffnx_glitch(x, ...) debug_printf("GLITCH", text_colors[TEXTCOLOR_GRAY], (x), ## __VA_ARGS__)
 #define ffnx_unexpected(x, ...) debug_printf("UNEXPECTED", text_colors[TEXTCOLOR_LIGHT_BLUE], (x), ## __VA_ARGS__)
 
 #define ffnx_glitch_once(x, ...) { static uint32_t glitch_ ## __LINE__ = false; if(!glitch_ ## __LINE__) { ffnx_glitch(x, ## __VA_ARGS__); glitch_ ## __LINE__ = true; } }
 #define ffnx_unexpected_once(x, ...) { static uint32_t unexpected_ ## __LINE__ = false; if(!unexpected_ ## __LINE__) { ffnx_unexpected(x, ## __VA_ARGS__); unexpected_ ## __LINE__ = true; } }
 
+// lines logged by a single call site during the current second, see trace_rate_limit
+struct log_rate_limit
+{
+	std::atomic<uint32_t> second = 0;
+	std::atomic<uint32_t> count = 0;
+	std::atomic<uint32_t> suppressed = 0;
+};
+
 void open_applog(char *path);
+void start_applog_writer();
+void flush_applog();
+
+bool log_rate_allowed(log_rate_limit &limit);
 
 void plugin_trace(const char *fmt, ...);
 void plugin_info(const char *fmt, ...);
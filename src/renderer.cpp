@@ -34,6 +34,7 @@
 #include "lighting.h"
 #include "ff7/widescreen.h"
 #include "image/image.h"
+#include "image/texture_cache.h"
 #include "gl.h"
 #include "log.h"
 #include "cfg.h"
@@ -332,9 +333,38 @@ bgfx::UniformHandle Renderer::setUniform(RendererUniform uniform, const void* un
 {
     bgfx::UniformHandle handle = bgfxUniformHandles[uniform];
 
+    if (batchKeyTarget != nullptr)
+    {
+        batchKeyTarget->insert(batchKeyTarget->end(), (const uint8_t*)uniformValue, (const uint8_t*)uniformValue + bgfxUniformSizes[uniform]);
+
+        return handle;
+    }
+
+    flushBatch();
+
     if (bgfx::isValid(handle))
     {
+        uint16_t size = bgfxUniformSizes[uniform];
+
+        if (internalState.bTrackUniforms)
+        {
+            // Same value as the last upload on this view, skip it
+            if (internalState.uniformCacheValid[uniform] && memcmp(internalState.uniformCache[uniform].data(), uniformValue, size) == 0)
+            {
+                stats.uniform_bytes_skipped += size;
+
+                return handle;
+            }
+
+            memcpy(internalState.uniformCache[uniform].data(), uniformValue, size);
+            internalState.uniformCacheValid.set(uniform);
+        }
+        // The view this upload will be used on is unknown, do not trust the cache anymore
+        else internalState.uniformCacheValid.reset();
+
         bgfx::setUniform(handle, uniformValue);
+
+        stats.uniform_bytes += size;
     }
 
     return handle;
@@ -682,6 +712,8 @@ void Renderer::prepareFramebuffer()
 
 void Renderer::bindTextures()
 {
+    flushBatch();
+
     if (!internalState.bTexturesBound)
     {
         for (uint32_t idx = RendererTextureSlot::TEX_Y; idx < RendererTextureSlot::COUNT; idx++)
@@ -1020,6 +1052,10 @@ void Renderer::init()
         .add(bgfx::Attrib::Normal, 3, bgfx::AttribType::Float)
         .end();
 
+    // Avoid growing the per-frame buffers during the first frames
+    vertexBufferData.reserve(16384);
+    indexBufferData.reserve(32768);
+
     bgfx::setDebug(BGFX_DEBUG_TEXT);
 
     bgfx::frame();
@@ -1078,6 +1114,16 @@ void Renderer::init()
     bgfxUniformHandles[RendererUniform::GAME_LIGHT_DIR3] = createUniform("gameLightDir3", bgfx::UniformType::Vec4);
     bgfxUniformHandles[RendererUniform::GAME_SCRIPTED_LIGHT_COLOR] = createUniform("gameScriptedLightColor", bgfx::UniformType::Vec4);
 
+    // Remember the size of every uniform, used to compare them when batching draw calls
+    for (uint32_t idx = 0; idx < RendererUniform::COUNT; idx++)
+    {
+        bgfx::UniformInfo info;
+
+        bgfx::getUniformInfo(bgfxUniformHandles[idx], info);
+
+        bgfxUniformSizes[idx] = (info.type == bgfx::UniformType::Mat4 ? 64 : (info.type == bgfx::UniformType::Mat3 ? 36 : 16)) * info.num;
+    }
+
     for(int i = 0; i < RendererTextureSlot::COUNT; ++i)
     {
         bgfxTexUniformHandles[i] = createUniform("tex_" + std::to_string(i), bgfx::UniformType::Sampler);
@@ -1316,6 +1362,8 @@ void Renderer::shutdown()
 
 void Renderer::clearShadowMap()
 {
+    flushBatch();
+
     bgfx::setViewClear(0, BGFX_CLEAR_DEPTH, internalState.clearColorValue, 1.0f, 0);
     bgfx::touch(0);
 }
@@ -1324,6 +1372,8 @@ void Renderer::drawToShadowMap(bool uniformsAlreadyAttached, bool texturesAlread
 {
     if (trace_all || trace_renderer) ffnx_trace("Renderer::%s with backendProgram %d\n", __func__, backendProgram);
 
+    flushBatch();
+
     // Lighting state
     auto lightingState = lighting.getLightingState();
 
@@ -1338,6 +1388,7 @@ void Renderer::drawToShadowMap(bool uniformsAlreadyAttached, bool texturesAlread
     bgfx::setViewTransform(0, lightingState.lightViewMatrix, lightingState.lightProjMatrix);
 
     // Set uniforms
+    // Not tracked: these are kept for the lighting draw which follows on another view
     if(!uniformsAlreadyAttached)
     {
         setLightingUniforms();
@@ -1364,13 +1415,19 @@ void Renderer::drawToShadowMap(bool uniformsAlreadyAttached, bool texturesAlread
     }
     bgfx::setState(internalState.state);
 
+    applyBuffers();
+
     bgfx::submit(0, backendProgramHandles[RendererProgram::SHADOW_MAP], 0, BGFX_DISCARD_NONE);
+
+    stats.draw_submits++;
 };
 
 void Renderer::drawWithLighting(bool uniformsAlreadyAttached, bool texturesAlreadyAttached, bool keepBindings)
 {
     if (trace_all || trace_renderer) ffnx_trace("Renderer::%s with backendProgram %d\n", __func__, backendProgram);
 
+    flushBatch();
+
     // Set lighting program
     backendProgram = backendProgram == SMOOTH ? LIGHTING_SMOOTH : LIGHTING_FLAT;
 
@@ -1401,6 +1458,8 @@ void Renderer::drawWithLighting(bool uniformsAlreadyAttached, bool texturesAlrea
 
 void Renderer::drawFieldShadow()
 {
+    flushBatch();
+
     backendProgram = RendererProgram::FIELD_SHADOW;
 
     // Re-Bind shadow map with comparison sampler
@@ -1412,10 +1471,189 @@ void Renderer::drawFieldShadow()
     draw();
 }
 
+void Renderer::updateState()
+{
+    internalState.state = BGFX_STATE_LINEAA | BGFX_STATE_MSAA | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A;
+
+    switch (internalState.cullMode)
+    {
+    case RendererCullMode::FRONT: internalState.state |= BGFX_STATE_CULL_CW;
+    case RendererCullMode::BACK: internalState.state |= BGFX_STATE_CULL_CCW;
+    }
+
+    switch (internalState.blendMode)
+    {
+    case RendererBlendMode::BLEND_AVG:
+        internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
+        internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+        break;
+    case RendererBlendMode::BLEND_ADD:
+        internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
+        internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_ONE);
+        break;
+    case RendererBlendMode::BLEND_SUB:
+        internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_REVSUB);
+        internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_ONE);
+        break;
+    case RendererBlendMode::BLEND_25P:
+        internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
+        internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_ONE);
+        break;
+    case RendererBlendMode::BLEND_NONE:
+        internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
+        if (internalState.bIsExternalTexture && !ff8) internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+        else internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_ZERO);
+        break;
+    }
+
+    switch (internalState.primitiveType)
+    {
+    case RendererPrimitiveType::PT_LINES:
+        internalState.state |= BGFX_STATE_PT_LINES;
+        break;
+    case RendererPrimitiveType::PT_POINTS:
+        internalState.state |= BGFX_STATE_PT_POINTS;
+        break;
+    }
+
+    if (internalState.bDoDepthTest) internalState.state |= BGFX_STATE_DEPTH_TEST_LEQUAL;
+
+    if (internalState.bDoDepthWrite) internalState.state |= BGFX_STATE_WRITE_Z;
+}
+
+void Renderer::beginUniformTracking(bgfx::ViewId viewId)
+{
+    // Views are rendered one after the other, a value uploaded for another view may have been overwritten in the meantime
+    if (viewId != internalState.uniformCacheViewId)
+    {
+        internalState.uniformCacheValid.reset();
+        internalState.uniformCacheViewId = viewId;
+    }
+
+    // Skipping is only safe when draws are executed in the order they were submitted
+    internalState.bTrackUniforms = enable_uniform_cache && viewId < internalState.sequentialViews.size() && internalState.sequentialViews[viewId];
+}
+
+void Renderer::setViewSequential(bgfx::ViewId viewId)
+{
+    bgfx::setViewMode(viewId, bgfx::ViewMode::Sequential);
+
+    if (viewId < internalState.sequentialViews.size()) internalState.sequentialViews.set(viewId);
+}
+
+void Renderer::applyBuffers()
+{
+    if (internalState.bHasBufferRange)
+    {
+        bgfx::setVertexBuffer(0, vertexBufferHandle, internalState.vertexOffset, internalState.vertexCount);
+        bgfx::setIndexBuffer(indexBufferHandle, internalState.indexOffset, internalState.indexCount);
+    }
+}
+
+void Renderer::updateBatchKey(std::vector<uint8_t>& key)
+{
+    auto append = [&key](const void* data, size_t size) { key.insert(key.end(), (const uint8_t*)data, (const uint8_t*)data + size); };
+
+    key.clear();
+
+    append(&backendViewId, sizeof(backendViewId));
+    append(&backendProgram, sizeof(backendProgram));
+    append(&internalState.state, sizeof(internalState.state));
+    append(internalState.backendProjMatrix, sizeof(internalState.backendProjMatrix));
+
+    append(&internalState.bDoScissorTest, sizeof(internalState.bDoScissorTest));
+    if (internalState.bDoScissorTest)
+    {
+        uint16_t scissor[] = { scissorOffsetX, scissorOffsetY, scissorWidth, scissorHeight };
+        append(scissor, sizeof(scissor));
+    }
+
+    // Textures and everything bindTextures uses to compute the sampler flags
+    for (const auto& handle : internalState.texHandlers) append(&handle.idx, sizeof(handle.idx));
+    append(&internalState.bDoMirrorTextureWrap, sizeof(internalState.bDoMirrorTextureWrap));
+    append(&internalState.bIsMovie, sizeof(internalState.bIsMovie));
+    append(&internalState.bDoTextureFiltering, sizeof(internalState.bDoTextureFiltering));
+    append(&internalState.bIsExternalTexture, sizeof(internalState.bIsExternalTexture));
+
+    // Uniform values, as they would be uploaded
+    batchKeyTarget = &key;
+    setCommonUniforms();
+    setLightingUniforms();
+    batchKeyTarget = nullptr;
+}
+
+bool Renderer::canMergeBatch()
+{
+    return pendingBatch.isPending
+        && pendingBatch.key == batchKey
+        && internalState.vertexOffset == pendingBatch.vertexOffset + pendingBatch.vertexCount
+        && internalState.indexOffset == pendingBatch.indexOffset + pendingBatch.indexCount
+        // Indices are 16-bit
+        && pendingBatch.vertexCount + internalState.vertexCount <= 0x10000;
+}
+
+void Renderer::mergeBatch()
+{
+    // Indices are relative to the first vertex of the draw, rebase them on the first vertex of the batch
+    WORD delta = pendingBatch.vertexCount;
+    WORD* indices = indexBufferData.data() + internalState.indexOffset;
+
+    for (uint32_t idx = 0; idx < internalState.indexCount; idx++) indices[idx] += delta;
+
+    pendingBatch.vertexCount += internalState.vertexCount;
+    pendingBatch.indexCount += internalState.indexCount;
+
+    internalState.bHasBufferRange = false;
+}
+
+void Renderer::flushBatch()
+{
+    if (!pendingBatch.isPending) return;
+
+    pendingBatch.isPending = false;
+
+    bgfx::setVertexBuffer(0, vertexBufferHandle, pendingBatch.vertexOffset, pendingBatch.vertexCount);
+    bgfx::setIndexBuffer(indexBufferHandle, pendingBatch.indexOffset, pendingBatch.indexCount);
+    bgfx::submit(pendingBatch.viewId, backendProgramHandles[pendingBatch.program], 0, BGFX_DISCARD_ALL);
+
+    stats.draw_submits++;
+}
+
 void Renderer::draw(bool uniformsAlreadyAttached, bool texturesAlreadyAttached, bool keepBindings)
 {
     if (trace_all || trace_renderer) ffnx_trace("Renderer::%s with backendProgram %d\n", __func__, backendProgram);
 
+    stats.draw_calls++;
+
+    // set up a gamut LUT if we need one
+    AssignGamutLUT();
+
+    updateState();
+
+    // Only plain game draws are batched, anything attaching its own bindings is submitted right away
+    bool isBatchable = enable_draw_call_batching
+        && !uniformsAlreadyAttached && !texturesAlreadyAttached && !keepBindings
+        && internalState.bHasBufferRange
+        && (backendProgram == RendererProgram::FLAT || backendProgram == RendererProgram::SMOOTH)
+        && internalState.primitiveType == RendererPrimitiveType::PT_TRIANGLES;
+
+    if (isBatchable)
+    {
+        updateBatchKey(batchKey);
+
+        if (canMergeBatch())
+        {
+            mergeBatch();
+
+            internalState.bHasDrawBeenDone = true;
+            internalState.bTexturesBound = false;
+
+            return;
+        }
+    }
+
+    flushBatch();
+
     // Set current view rect
     if (backendProgram == RendererProgram::POSTPROCESSING)
     {
@@ -1440,72 +1678,45 @@ void Renderer::draw(bool uniformsAlreadyAttached, bool texturesAlreadyAttached,
     // Skip uniform attachment as it has been done already
     if (!uniformsAlreadyAttached)
     {
+        beginUniformTracking(backendViewId);
         setCommonUniforms();
         setLightingUniforms();
+        internalState.bTrackUniforms = false;
     }
 
-    // set up a gamut LUT if we need one
-    AssignGamutLUT();
-
     // Bind textures in pipeline
     if (!texturesAlreadyAttached)
     {
         bindTextures();
     }
 
-    // Set state
-    {
-        internalState.state = BGFX_STATE_LINEAA | BGFX_STATE_MSAA | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A;
-
-        switch (internalState.cullMode)
-        {
-        case RendererCullMode::FRONT: internalState.state |= BGFX_STATE_CULL_CW;
-        case RendererCullMode::BACK: internalState.state |= BGFX_STATE_CULL_CCW;
-        }
+    bgfx::setState(internalState.state);
 
-        switch (internalState.blendMode)
-        {
-        case RendererBlendMode::BLEND_AVG:
-            internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
-            internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
-            break;
-        case RendererBlendMode::BLEND_ADD:
-            internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
-            internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_ONE);
-            break;
-        case RendererBlendMode::BLEND_SUB:
-            internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_REVSUB);
-            internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_ONE);
-            break;
-        case RendererBlendMode::BLEND_25P:
-            internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
-            internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_ONE);
-            break;
-        case RendererBlendMode::BLEND_NONE:
-            internalState.state |= BGFX_STATE_BLEND_EQUATION(BGFX_STATE_BLEND_EQUATION_ADD);
-            if (internalState.bIsExternalTexture && !ff8) internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
-            else internalState.state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_ZERO);
-            break;
-        }
+    if (isBatchable)
+    {
+        // Everything but the submit is set, following compatible draws will be merged into this one
+        pendingBatch.isPending = true;
+        pendingBatch.key.swap(batchKey);
+        pendingBatch.viewId = backendViewId;
+        pendingBatch.program = backendProgram;
+        pendingBatch.vertexOffset = internalState.vertexOffset;
+        pendingBatch.vertexCount = internalState.vertexCount;
+        pendingBatch.indexOffset = internalState.indexOffset;
+        pendingBatch.indexCount = internalState.indexCount;
+
+        internalState.bHasBufferRange = false;
+    }
+    else
+    {
+        applyBuffers();
 
-        switch (internalState.primitiveType)
-        {
-        case RendererPrimitiveType::PT_LINES:
-            internalState.state |= BGFX_STATE_PT_LINES;
-            break;
-        case RendererPrimitiveType::PT_POINTS:
-            internalState.state |= BGFX_STATE_PT_POINTS;
-            break;
-        }
+        auto flags = keepBindings ? BGFX_DISCARD_STATE : BGFX_DISCARD_ALL;
+        bgfx::submit(backendViewId, backendProgramHandles[backendProgram], 0, flags);
 
-        if (internalState.bDoDepthTest) internalState.state |= BGFX_STATE_DEPTH_TEST_LEQUAL;
+        stats.draw_submits++;
 
-        if (internalState.bDoDepthWrite) internalState.state |= BGFX_STATE_WRITE_Z;
+        if (!keepBindings) internalState.bHasBufferRange = false;
     }
-    bgfx::setState(internalState.state);
-
-    auto flags = keepBindings ? BGFX_DISCARD_STATE : BGFX_DISCARD_ALL;
-    bgfx::submit(backendViewId, backendProgramHandles[backendProgram], 0, flags);
 
     internalState.bHasDrawBeenDone = true;
     internalState.bTexturesBound = false;
@@ -1513,11 +1724,15 @@ void Renderer::draw(bool uniformsAlreadyAttached, bool texturesAlreadyAttached,
 
 void Renderer::discardAllBindings()
 {
+    flushBatch();
+
     bgfx::discard(BGFX_DISCARD_ALL);
 }
 
 void Renderer::drawOverlay()
 {
+    flushBatch();
+
     if (enable_devtools)
         overlay.draw();
 }
@@ -1597,6 +1812,8 @@ void Renderer::drawFFNxLogo(float fade)
 
 void Renderer::show()
 {
+    flushBatch();
+
     // Reset internal state
     resetState();
 
@@ -1633,13 +1850,14 @@ void Renderer::show()
 
     backendViewId = 1;
 
+    // Keep the capacity, next frame will likely need as much
     vertexBufferData.clear();
-    vertexBufferData.shrink_to_fit();
-
     indexBufferData.clear();
-    indexBufferData.shrink_to_fit();
 
-    bgfx::setViewMode(backendViewId, bgfx::ViewMode::Sequential);
+    internalState.uniformCacheValid.reset();
+    internalState.sequentialViews.reset();
+
+    setViewSequential(backendViewId);
 }
 
 void Renderer::printText(uint16_t x, uint16_t y, uint32_t color, const char* text)
@@ -1678,30 +1896,43 @@ void Renderer::bindVertexBuffer(struct nvertex* inVertex, vector3<float>* normal
 
     uint32_t currentOffset = vertexBufferData.size();
 
+    // Grow once per call. The capacity is kept across frames, so this does not allocate once the peak frame size is reached.
+    // New elements are value-initialized, which leaves the normals to zero when none are given.
+    vertexBufferData.resize(currentOffset + inCount);
+
+    Vertex* outVertex = vertexBufferData.data() + currentOffset;
+
     for (uint32_t idx = 0; idx < inCount; idx++)
     {
-        vertexBufferData.push_back(Vertex());
-
-        vertexBufferData[currentOffset + idx].x = inVertex[idx]._.x;
-        vertexBufferData[currentOffset + idx].y = inVertex[idx]._.y;
-        vertexBufferData[currentOffset + idx].z = inVertex[idx]._.z;
-        vertexBufferData[currentOffset + idx].w = ( ::isinf(inVertex[idx].color.w) ? 1.0f : inVertex[idx].color.w );
-        vertexBufferData[currentOffset + idx].bgra = inVertex[idx].color.color;
-        vertexBufferData[currentOffset + idx].u = inVertex[idx].u;
-        vertexBufferData[currentOffset + idx].v = inVertex[idx].v;
+        const struct nvertex& vertex = inVertex[idx];
+        Vertex& out = outVertex[idx];
+
+        out.x = vertex._.x;
+        out.y = vertex._.y;
+        out.z = vertex._.z;
+        out.w = ( ::isinf(vertex.color.w) ? 1.0f : vertex.color.w );
+        out.bgra = vertex.color.color;
+        out.u = vertex.u;
+        out.v = vertex.v;
+    }
 
-        if (normals)
+    if (normals)
+    {
+        for (uint32_t idx = 0; idx < inCount; idx++)
         {
-            vertexBufferData[currentOffset + idx].nx = normals[idx].x;
-            vertexBufferData[currentOffset + idx].ny = normals[idx].y;
-            vertexBufferData[currentOffset + idx].nz = normals[idx].z;
+            outVertex[idx].nx = normals[idx].x;
+            outVertex[idx].ny = normals[idx].y;
+            outVertex[idx].nz = normals[idx].z;
         }
-
-        if (vertex_log && idx == 0) ffnx_trace("%s: %u [XYZW(%f, %f, %f, %f), BGRA(%08x), UV(%f, %f)]\n", __func__, idx, vertexBufferData[currentOffset + idx].x, vertexBufferData[currentOffset + idx].y, vertexBufferData[currentOffset + idx].z, vertexBufferData[currentOffset + idx].w, vertexBufferData[currentOffset + idx].bgra, vertexBufferData[currentOffset + idx].u, vertexBufferData[currentOffset + idx].v);
-        if (vertex_log && idx == 1) ffnx_trace("%s: See the rest on RenderDoc.\n", __func__);
     }
 
-    bgfx::setVertexBuffer(0, vertexBufferHandle, currentOffset, inCount);
+    if (vertex_log && inCount > 0) ffnx_trace("%s: %u [XYZW(%f, %f, %f, %f), BGRA(%08x), UV(%f, %f)]\n", __func__, 0, outVertex[0].x, outVertex[0].y, outVertex[0].z, outVertex[0].w, outVertex[0].bgra, outVertex[0].u, outVertex[0].v);
+    if (vertex_log && inCount > 1) ffnx_trace("%s: See the rest on RenderDoc.\n", __func__);
+
+    // Attached by the next draw, which may merge it with the previous one
+    internalState.bHasBufferRange = true;
+    internalState.vertexOffset = currentOffset;
+    internalState.vertexCount = inCount;
 };
 
 void Renderer::bindIndexBuffer(WORD* inIndex, uint32_t inCount)
@@ -1710,12 +1941,10 @@ void Renderer::bindIndexBuffer(WORD* inIndex, uint32_t inCount)
 
     uint32_t currentOffset = indexBufferData.size();
 
-    for (uint32_t idx = 0; idx < inCount; idx++)
-    {
-        indexBufferData.push_back(inIndex[idx]);
-    }
+    indexBufferData.insert(indexBufferData.end(), inIndex, inIndex + inCount);
 
-    bgfx::setIndexBuffer(indexBufferHandle, currentOffset, inCount);
+    internalState.indexOffset = currentOffset;
+    internalState.indexCount = inCount;
 };
 
 void Renderer::setScissor(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
@@ -1826,6 +2055,8 @@ void Renderer::setClearFlags(bool doClearColor, bool doClearDepth)
 {
     if (trace_all || trace_renderer) ffnx_trace("Renderer::%s clearColor=%d,clearDepth=%d\n", __func__, doClearColor, doClearDepth);
 
+    flushBatch();
+
     uint16_t clearFlags = BGFX_CLEAR_NONE;
 
     if (doClearColor)
@@ -1914,6 +2145,35 @@ uint32_t Renderer::createTexture(uint8_t* data, size_t width, size_t height, int
     return ret.idx;
 };
 
+// Replace the content of a texture created by createTexture, without reallocating it
+void Renderer::updateTexture(uint16_t rt, uint8_t* data, size_t width, size_t height, int stride, RendererTextureType type)
+{
+    bgfx::TextureHandle handle = { rt };
+
+    if (rt == 0 || !bgfx::isValid(handle) || data == NULL) return;
+
+    bimg::TextureFormat::Enum imgFormat = type == RendererTextureType::BGRA ? bimg::TextureFormat::BGRA8 : bimg::TextureFormat::R8;
+
+    bimg::TextureInfo texInfo;
+    bimg::imageGetSize(&texInfo, width, height, 0, false, false, 1, imgFormat);
+
+    uint32_t pitch = stride > 0 ? stride : texInfo.storageSize / height;
+
+    bgfx::updateTexture2D(
+        handle,
+        0,
+        0,
+        0,
+        0,
+        width,
+        height,
+        bgfx::copy(data, pitch * height),
+        pitch
+    );
+
+    if (trace_all || trace_renderer) ffnx_trace("Renderer::%s: %u => %ux%u from data with stride %u\n", __func__, rt, width, height, stride);
+}
+
 uint32_t Renderer::createTexture(char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb)
 {
     bgfx::TextureHandle handle = createTextureHandle(filename, width, height, mipCount, isSrgb);
@@ -1939,59 +2199,24 @@ bimg::ImageContainer* Renderer::createImageContainer(cmrc::file* file, bimg::Tex
 
 bgfx::TextureHandle Renderer::createTextureHandle(char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb)
 {
-    bgfx::TextureHandle ret = FFNX_RENDERER_INVALID_HANDLE;
-    bimg::ImageContainer* img = createImageContainer(filename);
-
-    if (img != nullptr)
-    {
-        if (gl_check_texture_dimensions(img->m_width, img->m_height, filename) && doesItFitInMemory(img->m_size))
-        {
-            uint64_t flags = BGFX_SAMPLER_NONE;
-
-            if (isSrgb) flags |= BGFX_TEXTURE_SRGB;
-            else flags |= BGFX_TEXTURE_NONE;
+    // Prefer the block-compressed copy, if any
+    bimg::ImageContainer* img = textureCache.load(&defaultAllocator, filename);
 
-            const bgfx::Memory* mem = bgfx::makeRef(img->m_data, img->m_size, RendererReleaseImageContainer, img);
-            if (img->m_cubeMap)
-            {
-                ret = bgfx::createTextureCube(
-                    img->m_width,
-                    1 < img->m_numMips,
-                    img->m_numLayers,
-                    bgfx::TextureFormat::Enum(img->m_format),
-                    flags,
-                    mem
-                );
-            }
-            else
-            {
+    if (img == nullptr) img = createImageContainer(filename);
 
-                ret = bgfx::createTexture2D(
-                    img->m_width,
-                    img->m_height,
-                    1 < img->m_numMips,
-                    img->m_numLayers,
-                    bgfx::TextureFormat::Enum(img->m_format),
-                    flags,
-                    mem
-                );
-            }
-
-            *width = img->m_width;
-            *height = img->m_height;
-            *mipCount = img->m_numMips;
+    return createTextureHandle(img, filename, width, height, mipCount, isSrgb);
+}
 
-            if (trace_all || trace_renderer) ffnx_trace("Renderer::%s: %u => %ux%u from filename %s\n", __func__, ret.idx, width, height, filename);
-        }
-    }
+bgfx::TextureHandle Renderer::createTextureHandle(cmrc::file* file, char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb)
+{
+    bimg::ImageContainer* img = createImageContainer(file);
 
-    return ret;
+    return createTextureHandle(img, filename, width, height, mipCount, isSrgb);
 }
 
-bgfx::TextureHandle Renderer::createTextureHandle(cmrc::file* file, char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb)
+bgfx::TextureHandle Renderer::createTextureHandle(bimg::ImageContainer* img, char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb)
 {
     bgfx::TextureHandle ret = FFNX_RENDERER_INVALID_HANDLE;
-    bimg::ImageContainer* img = createImageContainer(file);
 
     if (img != nullptr)
     {
@@ -2034,6 +2259,8 @@ bgfx::TextureHandle Renderer::createTextureHandle(cmrc::file* file, char* filena
 
             if (trace_all || trace_renderer) ffnx_trace("Renderer::%s: %u => %ux%u from filename %s\n", __func__, ret.idx, width, height, filename);
         }
+        else
+            bimg::imageFree(img);
     }
 
     return ret;
@@ -2044,6 +2271,15 @@ uint32_t Renderer::createTextureLibPng(char* filename, uint32_t* width, uint32_t
     bgfx::TextureHandle ret = FFNX_RENDERER_INVALID_HANDLE;
     bimg::ImageMip mip;
 
+    // Prefer the block-compressed copy, if any
+    bimg::ImageContainer* img = textureCache.load(&defaultAllocator, filename);
+
+    if (img != nullptr) {
+        uint32_t mipCount = 0;
+
+        return createTextureHandle(img, filename, width, height, &mipCount, isSrgb).idx;
+    }
+
     if (!loadPng(filename, mip)) {
         return ret.idx;
     }
@@ -2104,6 +2340,9 @@ void Renderer::deleteTexture(uint16_t rt)
         bgfx::TextureHandle handle = { rt };
 
         if (bgfx::isValid(handle)) {
+            // A pending batch may still use it
+            flushBatch();
+
             bgfx::destroy(handle);
 
             if (trace_all || trace_renderer) ffnx_trace("Renderer::%s: %u Texture was valid and is now destroyed!\n", __func__, rt);
@@ -2171,6 +2410,8 @@ void Renderer::blitTexture(uint16_t dest, uint32_t x, uint32_t y, uint32_t width
         }
     }
 
+    flushBatch();
+
     backendViewId++;
 
     bgfx::TextureHandle texHandle = { dest };
@@ -2186,6 +2427,8 @@ void Renderer::zoomBackendFrameBuffer(int x, int y, int width, int height)
 {
     if(!internalState.bHasDrawBeenDone) return;
 
+    flushBatch();
+
     bgfx::TextureHandle textureHandle = bgfx::createTexture2D(width, height, false, 1, internalState.bIsHDR ? bgfx::TextureFormat::RGB10A2 : bgfx::TextureFormat::RGBA16, BGFX_TEXTURE_BLIT_DST);
 
     backendViewId++;
@@ -2258,8 +2501,10 @@ void Renderer::zoomBackendFrameBuffer(int x, int y, int width, int height)
 
 void Renderer::clearDepthBuffer()
 {
+    flushBatch();
+
     backendViewId++;
-    bgfx::setViewMode(backendViewId, bgfx::ViewMode::Sequential);
+    setViewSequential(backendViewId);
     bgfx::setViewRect(backendViewId, 0, 0, framebufferWidth, framebufferHeight);
     bgfx::setViewFrameBuffer(backendViewId, backendFrameBuffer);
     bgfx::setViewClear(backendViewId, BGFX_CLEAR_DEPTH);
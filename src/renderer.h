@@ -28,6 +28,7 @@
 #include <cmrc/cmrc.hpp>
 #include <vector>
 #include <array>
+#include <bitset>
 #include <string>
 #include <math.h>
 #include <bx/math.h>
@@ -328,6 +329,35 @@ private:
         uint64_t state = BGFX_STATE_MSAA;
 
         bool isViewMatrixSet = false;
+
+        // Ranges appended by bindVertexBuffer/bindIndexBuffer, attached right before the submit
+        bool bHasBufferRange = false;
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexOffset = 0;
+        uint32_t indexCount = 0;
+
+        // Last value uploaded for every uniform on uniformCacheViewId, bgfx keeps them until they are set again
+        bool bTrackUniforms = false;
+        bgfx::ViewId uniformCacheViewId = 0;
+        // bgfx sorts the draws of the other views, so the previously executed draw is not the previously submitted one
+        // Sized after the default BGFX_CONFIG_MAX_VIEWS
+        std::bitset<256> sequentialViews;
+        std::array<std::array<float, 16>, RendererUniform::COUNT> uniformCache;
+        std::bitset<RendererUniform::COUNT> uniformCacheValid;
+    };
+
+    // A draw which has been fully set up but not submitted yet, so following compatible draws can be merged into it
+    struct RendererBatch
+    {
+        bool isPending = false;
+        std::vector<uint8_t> key;
+        bgfx::ViewId viewId = 0;
+        RendererProgram program = RendererProgram::SMOOTH;
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexOffset = 0;
+        uint32_t indexCount = 0;
     };
 
     std::string vertexPathFlat = "shaders/FFNx";
@@ -385,10 +415,16 @@ private:
     bgfx::VertexLayout vertexLayout;
 
     std::array<bgfx::UniformHandle, RendererUniform::COUNT> bgfxUniformHandles;
+    std::array<uint16_t, RendererUniform::COUNT> bgfxUniformSizes;
     std::array<bgfx::UniformHandle, RendererTextureSlot::COUNT> bgfxTexUniformHandles;
 
     RendererState internalState;
 
+    RendererBatch pendingBatch;
+    std::vector<uint8_t> batchKey;
+    // When set, setUniform appends the uniform values here instead of uploading them
+    std::vector<uint8_t>* batchKeyTarget = nullptr;
+
     uint16_t viewOffsetX = 0;
     uint16_t viewOffsetY = 0;
     uint16_t viewWidth = 0;
@@ -429,6 +465,14 @@ private:
 
     void AssignGamutLUT();
 
+    void updateState();
+    void beginUniformTracking(bgfx::ViewId viewId);
+    void setViewSequential(bgfx::ViewId viewId);
+    void applyBuffers();
+    void updateBatchKey(std::vector<uint8_t>& key);
+    bool canMergeBatch();
+    void mergeBatch();
+
     bx::DefaultAllocator defaultAllocator;
     bx::FileWriter defaultWriter;
     Overlay overlay;
@@ -459,6 +503,7 @@ public:
     void drawFieldShadow();
     void draw(bool uniformsAlreadyAttached = false, bool texturesAlreadyAttached = false, bool keepBindings = false);
     void discardAllBindings();
+    void flushBatch();
     void drawOverlay();
     void drawFFNxLogo(float fade);
     void show();
@@ -485,11 +530,13 @@ public:
     void setBackgroundColor(float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 0.0f);
 
     uint32_t createTexture(uint8_t* data, size_t width, size_t height, int stride = 0, RendererTextureType type = RendererTextureType::BGRA, bool isSrgb = true, bool copyData = true);
+    void updateTexture(uint16_t texId, uint8_t* data, size_t width, size_t height, int stride = 0, RendererTextureType type = RendererTextureType::BGRA);
     uint32_t createTexture(char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb = true);
     bimg::ImageContainer* createImageContainer(const char* filename, bimg::TextureFormat::Enum targetFormat = bimg::TextureFormat::Enum::Count);
     bimg::ImageContainer* createImageContainer(cmrc::file* file, bimg::TextureFormat::Enum targetFormat = bimg::TextureFormat::Enum::Count);
     bgfx::TextureHandle createTextureHandle(char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb = true);
     bgfx::TextureHandle createTextureHandle(cmrc::file* file, char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb = true);
+    bgfx::TextureHandle createTextureHandle(bimg::ImageContainer* img, char* filename, uint32_t* width, uint32_t* height, uint32_t* mipCount, bool isSrgb = true);
     uint32_t createTextureLibPng(char* filename, uint32_t* width, uint32_t* height, bool isSrgb = true);
     bool saveTexture(const char* filename, uint32_t width, uint32_t height, const void* data);
     void deleteTexture(uint16_t texId);
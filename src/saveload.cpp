@@ -27,8 +27,11 @@
 #include "log.h"
 #include "gl.h"
 #include "utils.h"
+#include "file_index.h"
+#include "image/texture_decoder.h"
 
 #include <xxhash.h>
+#include <unordered_set>
 
 // TEMPORARY! WILL BE REMOVED AFTER MIGRATION.
 #include <iostream>
@@ -41,6 +44,45 @@ std::map<uint16_t, std::string> additional_textures = {
 	{RendererTextureSlot::TEX_PBR, "pbr"}
 };
 
+// Lookups which did not find any external texture, so they are not probed again
+std::unordered_set<std::string> missing_textures;
+std::string missing_textures_mod_path;
+uint32_t missing_textures_hits = 0;
+
+std::string get_missing_texture_key(const std::string& tex_path, const char* name, uint32_t palette_index, uint16_t slot)
+{
+	char key[1024]{ 0 };
+
+	_snprintf(key, sizeof(key), "%s|%s|%u|%u", tex_path.c_str(), name, palette_index, slot);
+
+	return key;
+}
+
+bool is_missing_texture(const std::string& key)
+{
+	bool ret = missing_textures.contains(key);
+
+	if (ret) missing_textures_hits++;
+
+	return ret;
+}
+
+void clear_missing_textures()
+{
+	missing_textures.clear();
+	missing_textures_hits = 0;
+}
+
+uint32_t get_missing_textures_count()
+{
+	return missing_textures.size();
+}
+
+uint32_t get_missing_textures_hits()
+{
+	return missing_textures_hits;
+}
+
 void make_path(const char *name)
 {
 	const char *next = name;
@@ -113,6 +155,13 @@ void save_texture(const void *data, uint32_t dataSize, uint32_t width, uint32_t
 		ffnx_warning("Save texture skipped because the file [ %s ] already exists.\n", filename);
 }
 
+bool texture_exists(const char* filename)
+{
+	if (enable_mod_path_index) return modPathIndex.exists(filename);
+
+	return fileExists(filename);
+}
+
 uint32_t load_texture_helper(char* name, uint32_t* width, uint32_t* height, bool useLibPng, bool isSrgb)
 {
 	uint32_t ret = 0;
@@ -135,12 +184,16 @@ uint32_t load_texture_helper(char* name, uint32_t* width, uint32_t* height, bool
 	return ret;
 }
 
-uint32_t load_normal_texture(const void* data, uint32_t dataSize, const char* name, uint32_t palette_index, uint32_t* width, uint32_t* height, struct gl_texture_set* gl_set, std::string tex_path)
+uint32_t load_normal_texture(const void* data, uint32_t dataSize, const char* name, uint32_t palette_index, uint32_t* width, uint32_t* height, struct gl_texture_set* gl_set, std::string tex_path, TextureDecoderCallback on_ready)
 {
 	uint32_t ret = 0;
 	char filename[sizeof(basedir) + 1024]{ 0 };
+	bool is_async = on_ready && textureDecoder.isEnabled();
+	bool is_pending = false;
+	std::string missing_key = get_missing_texture_key(tex_path, name, palette_index, RendererTextureSlot::TEX_Y);
+	bool is_missing = is_missing_texture(missing_key);
 
-	for (int idx = 0; idx < mod_ext.size(); idx++)
+	for (int idx = 0; !is_missing && idx < mod_ext.size(); idx++)
 	{
 		if (palette_index == uint32_t(-1))
 		{
@@ -155,6 +208,22 @@ uint32_t load_normal_texture(const void* data, uint32_t dataSize, const char* na
 			_snprintf(filename, sizeof(filename), "%s/%s/%s_%02i.%s", basedir, tex_path.c_str(), name, palette_index, mod_ext[idx].c_str());
 		}
 
+		// Decode in background, the caller keeps using the original texture until on_ready is called
+		if (is_async)
+		{
+			normalize_path(filename);
+
+			if (texture_exists(filename))
+			{
+				is_pending = textureDecoder.enqueue(filename, mod_ext[idx] == "png", true, gl_set, palette_index, RendererTextureSlot::TEX_Y, on_ready);
+				break;
+			}
+
+			continue;
+		}
+
+		if (!texture_exists(filename)) continue;
+
 		ret = load_texture_helper(filename, width, height, mod_ext[idx] == "png", true);
 
 		if(ret)
@@ -164,25 +233,27 @@ uint32_t load_normal_texture(const void* data, uint32_t dataSize, const char* na
 		}
 	}
 
-	if(!ret)
+	if(!ret && !is_pending)
 	{
+		if (!is_missing) missing_textures.insert(missing_key);
+
 		if(palette_index != uint32_t(-1) && (palette_index & 0x3FFFFFFF) != 0)
 		{
-			if(trace_all || show_missing_textures) ffnx_info("No external texture found [%s], falling back to palette 0\n", filename);
+			if(!is_missing && (trace_all || show_missing_textures)) ffnx_info("No external texture found [%s], falling back to palette 0\n", filename);
 			if(gl_set->default_texture_id)
 			{
 				return gl_set->default_texture_id;
 			}
 			else
 			{
-				gl_set->default_texture_id = load_normal_texture(data, dataSize, name, (palette_index & 0xC0000000) == 0xC0000000 ? -1 : (palette_index & 0x40000000), width, height, gl_set, tex_path);
+				gl_set->default_texture_id = load_normal_texture(data, dataSize, name, (palette_index & 0xC0000000) == 0xC0000000 ? -1 : (palette_index & 0x40000000), width, height, gl_set, tex_path, nullptr);
 
 				return gl_set->default_texture_id;
 			}
 		}
 		else
 		{
-			if(trace_all || show_missing_textures) ffnx_info("No external texture found [%s], switching back to the internal one.\n", filename);
+			if(!is_missing && (trace_all || show_missing_textures)) ffnx_info("No external texture found [%s], switching back to the internal one.\n", filename);
 			return 0;
 		}
 	}
@@ -191,6 +262,11 @@ uint32_t load_normal_texture(const void* data, uint32_t dataSize, const char* na
 		// Load additional textures
 		for (const auto& it : additional_textures)
 		{
+			std::string additional_missing_key = get_missing_texture_key(tex_path, name, palette_index, it.first);
+			bool is_additional_found = false;
+
+			if (is_missing_texture(additional_missing_key)) continue;
+
 			for (int idx = 0; idx < mod_ext.size(); idx++)
 			{
 				if (palette_index == uint32_t(-1))
@@ -206,8 +282,22 @@ uint32_t load_normal_texture(const void* data, uint32_t dataSize, const char* na
 					_snprintf(filename, sizeof(filename), "%s/%s/%s_%02i_%s.%s", basedir, tex_path.c_str(), name, palette_index, it.second.c_str(), mod_ext[idx].c_str());
 				}
 
-				if (fileExists(filename))
+				if (texture_exists(filename))
 				{
+					is_additional_found = true;
+
+					if (is_async)
+					{
+						normalize_path(filename);
+
+						textureDecoder.enqueue(filename, mod_ext[idx] == "png", false, gl_set, palette_index, it.first, [gl_set, slot = it.first](uint32_t texture, uint32_t width, uint32_t height)
+						{
+							if (gl_set->additional_textures.count(slot)) newRenderer.deleteTexture(gl_set->additional_textures[slot]);
+							gl_set->additional_textures[slot] = texture;
+						});
+						break;
+					}
+
 					if (gl_set->additional_textures.count(it.first)) newRenderer.deleteTexture(gl_set->additional_textures[it.first]);
 					gl_set->additional_textures[it.first] = load_texture_helper(filename, width, height, mod_ext[idx] == "png", false);
 					break;
@@ -217,6 +307,8 @@ uint32_t load_normal_texture(const void* data, uint32_t dataSize, const char* na
 					ffnx_trace("Could not find [ %s ].\n", filename);
 				}
 			}
+
+			if (!is_additional_found) missing_textures.insert(additional_missing_key);
 		}
 	}
 
@@ -237,12 +329,16 @@ uint32_t load_animated_texture(const void* data, uint32_t dataSize, const char*
 		return gl_set->animated_textures[texture_key];
 	}
 
+	// Misses of the hashed name are not remembered globally, there is one per animation frame.
+	// They are remembered per texture set by the zero entry set below, and freed with it.
+	std::string missing_key = get_missing_texture_key(tex_path, name, palette_index, RendererTextureSlot::TEX_Y);
+
 	// Check for animated texture with hash
 	for (int idx = 0; idx < mod_ext.size(); idx++)
 	{
 		_snprintf(filename, sizeof(filename), "%s/%s/%s_%02i_%llx.%s", basedir, tex_path.c_str(), name, palette_index, hash, mod_ext[idx].c_str());
 
-		ret = load_texture_helper(filename, width, height, mod_ext[idx] == "png", true);
+		ret = texture_exists(filename) ? load_texture_helper(filename, width, height, mod_ext[idx] == "png", true) : 0;
 
 		if(ret)
 		{
@@ -252,14 +348,17 @@ uint32_t load_animated_texture(const void* data, uint32_t dataSize, const char*
 		}
 
 		if (trace_all || show_missing_textures) ffnx_trace("Could not find animated texture [ %s ].\n", filename);
+
 	}
 
+	bool is_missing = is_missing_texture(missing_key);
+
 	// If animated texture not found, check for base texture
-	for (int idx = 0; idx < mod_ext.size(); idx++)
+	for (int idx = 0; !is_missing && idx < mod_ext.size(); idx++)
 	{
 		_snprintf(filename, sizeof(filename), "%s/%s/%s_%02i.%s", basedir, tex_path.c_str(), name, palette_index, mod_ext[idx].c_str());
 
-		ret = load_texture_helper(filename, width, height, mod_ext[idx] == "png", true);
+		ret = texture_exists(filename) ? load_texture_helper(filename, width, height, mod_ext[idx] == "png", true) : 0;
 
 		if(ret)
 		{
@@ -271,6 +370,8 @@ uint32_t load_animated_texture(const void* data, uint32_t dataSize, const char*
 		if (trace_all || show_missing_textures) ffnx_trace("Could not find base texture [ %s ].\n", filename);
 	}
 
+	if (!is_missing) missing_textures.insert(missing_key);
+
 	// Finally, if everything fails, return the one with palette index 0 or no texture
 	if(palette_index != 0)
 	{
@@ -301,9 +402,17 @@ uint32_t load_animated_texture(const void* data, uint32_t dataSize, const char*
 
 }
 
-uint32_t load_texture(const void* data, uint32_t dataSize, const char* name, uint32_t palette_index, uint32_t* width, uint32_t* height, struct gl_texture_set* gl_set)
+uint32_t load_texture(const void* data, uint32_t dataSize, const char* name, uint32_t palette_index, uint32_t* width, uint32_t* height, struct gl_texture_set* gl_set, TextureDecoderCallback on_ready)
 {
 	uint32_t ret = 0;
+	std::string current_mod_path = mod_path + "|" + override_mod_path;
+
+	// Lookups are relative to the mod paths, forget about previous misses if they changed
+	if (current_mod_path != missing_textures_mod_path)
+	{
+		clear_missing_textures();
+		missing_textures_mod_path = current_mod_path;
+	}
 
 	if(gl_set->is_animated)
 	{
@@ -315,11 +424,15 @@ uint32_t load_texture(const void* data, uint32_t dataSize, const char* name, uin
 	}
 	else
 	{
+		// A decode for this palette is already in flight, wait for it
+		if (textureDecoder.isPending(gl_set, palette_index))
+			return 0;
+
 		if (!override_mod_path.empty())
-			ret = load_normal_texture(data, dataSize, name, palette_index, width, height, gl_set, override_mod_path);
+			ret = load_normal_texture(data, dataSize, name, palette_index, width, height, gl_set, override_mod_path, on_ready);
 
-		if (ret == 0)
-			ret = load_normal_texture(data, dataSize, name, palette_index, width, height, gl_set, mod_path);
+		if (ret == 0 && !textureDecoder.isPending(gl_set, palette_index))
+			ret = load_normal_texture(data, dataSize, name, palette_index, width, height, gl_set, mod_path, on_ready);
 	}
 
 	return ret;
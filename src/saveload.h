@@ -23,7 +23,12 @@
 
 #include <stdint.h>
 
+#include "image/texture_decoder.h"
+
 void make_path(const char *name);
 void normalize_path(char *name);
 void save_texture(const void *data, uint32_t dataSize, uint32_t width, uint32_t height, uint32_t palette_index, const char *name, bool is_animated);
-uint32_t load_texture(const void *data, uint32_t dataSize, const char *name, uint32_t palette_index, uint32_t *width, uint32_t *height, struct gl_texture_set* gl_set);
+void clear_missing_textures();
+uint32_t get_missing_textures_count();
+uint32_t get_missing_textures_hits();
+uint32_t load_texture(const void *data, uint32_t dataSize, const char *name, uint32_t palette_index, uint32_t *width, uint32_t *height, struct gl_texture_set* gl_set, TextureDecoderCallback on_ready = nullptr);
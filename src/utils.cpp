@@ -49,6 +49,25 @@ bool dirExists(const char *dirname)
     return stat(dirname, &dummy) == 0;
 }
 
+bool pathToAnsi(const std::filesystem::path& path, std::string& out)
+{
+    const std::wstring& wide = path.native();
+
+    out.clear();
+
+    if (wide.empty()) return true;
+
+    BOOL usedDefaultChar = FALSE;
+    int size = WideCharToMultiByte(CP_ACP, WC_NO_BEST_FIT_CHARS, wide.c_str(), int(wide.size()), nullptr, 0, nullptr, &usedDefaultChar);
+
+    if (size <= 0 || usedDefaultChar) return false;
+
+    out.resize(size);
+    WideCharToMultiByte(CP_ACP, WC_NO_BEST_FIT_CHARS, wide.c_str(), int(wide.size()), out.data(), size, nullptr, nullptr);
+
+    return true;
+}
+
 std::string getCopyrightInfoFromExe(const std::string& filePath)
 {
     // Get the size of the version information
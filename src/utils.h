@@ -26,6 +26,7 @@
 #include <vector>
 #include <chrono>
 #include <random>
+#include <filesystem>
 
 // Get the size of a vector in bytes
 template<typename T>
@@ -139,6 +140,8 @@ inline long double elapsedMicroseconds(std::chrono::time_point<std::chrono::high
 
 bool fileExists(const char *filename);
 bool dirExists(const char *dirname);
+// Returns false if the path can't be represented in the current ANSI code page, which is what the game uses for its paths
+bool pathToAnsi(const std::filesystem::path& path, std::string& out);
 std::string getCopyrightInfoFromExe(const std::string& filePath);
 std::wstring GetErrorMessage(unsigned long errorCode);
 bool isFileSigned(const wchar_t* dllPath);
@@ -25,7 +25,18 @@
 
 #include "movies.h"
 
+#include <atomic>
 #include <cctype>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#include <tmmintrin.h>
+#define MOVIES_SSSE3
+#endif
 
 // 10 frames
 #define VIDEO_BUFFER_SIZE 10
@@ -43,12 +54,22 @@ AVFrame *movie_frame = 0;
 struct SwsContext *sws_ctx = 0;
 SwrContext* swr_ctx = NULL;
 
+// hardware decoding, see create_hw_device
+AVBufferRef *hw_device_ctx = 0;
+AVHWDeviceType hw_device_type = AV_HWDEVICE_TYPE_NONE;
+AVPixelFormat hw_pix_fmt = AV_PIX_FMT_NONE;
+AVFrame *hw_transfer_frame = 0;
+bool hw_decoding = false;
+
 int videostream;
 int audiostream;
 
 struct video_frame
 {
 	uint32_t yuv_textures[3] = { 0 };
+	// textures are kept across frames and only recreated when their size changes
+	uint32_t yuv_widths[3] = { 0 };
+	uint32_t yuv_heights[3] = { 0 };
 };
 
 struct video_frame video_buffer[VIDEO_BUFFER_SIZE];
@@ -65,12 +86,55 @@ ColorMatrixType colormatrix = COLORMATRIX_BT601;
 ColorGamutType colorgamut = COLORGAMUT_SRGB;
 InverseGammaFunctionType gammatype = GAMMAFUNCTION_SRGB;
 AVPixelFormat targetpixelformat = AV_PIX_FMT_YUV444P;
+// source format of sws_ctx, the decoded frames may not match codec_ctx->pix_fmt when using hardware decoding
+AVPixelFormat sws_src_format = AV_PIX_FMT_NONE;
+bool okcolorspace = false;
+bool yuvjfixneeded = false;
 
 bool first_audio_packet;
 
+// the end of the file was reached and the video decoder is returning the frames it still holds
+bool video_draining = false;
+
 time_t timer_freq;
 time_t start_time;
 
+bool timer_resolution_raised = false;
+
+// decoded frames waiting to be uploaded, written by the decoder thread and read by the game thread
+struct decoded_frame
+{
+	uint8_t *planes[4] = { 0 };
+	int strides[4] = { 0 };
+};
+
+std::vector<decoded_frame> frame_ring;
+std::atomic<uint32_t> frame_ring_read = 0;
+std::atomic<uint32_t> frame_ring_write = 0;
+// only used to sleep while the ring is full or empty
+std::mutex frame_ring_mutex;
+std::condition_variable frame_ring_cv;
+bool movie_decoder_stop = false;
+bool movie_decoder_finished = false;
+bool movie_decoder_threaded = false;
+std::thread movie_decoder;
+
+uint32_t movie_dropped_frames = 0;
+
+// scratch frame used by sws_scale when decoding on the game thread
+uint8_t *sws_planes[4] = { 0 };
+int sws_strides[4] = { 0 };
+
+// planar copy of BGR24 frames, see buffer_yuv_frame
+std::vector<uint8_t> bgr24_planes;
+
+// number of textures created since the movie was prepared
+uint32_t movie_texture_allocations = 0;
+
+// decoding speed since the movie was prepared
+uint32_t movie_decoded_frames = 0;
+time_t movie_decode_time = 0;
+
 void ffmpeg_movie_init()
 {
 	ffnx_info("FFMpeg movie player plugin loaded\n");
@@ -78,13 +142,429 @@ void ffmpeg_movie_init()
 	QueryPerformanceFrequency((LARGE_INTEGER *)&timer_freq);
 }
 
+// decode packets until a video frame is available in movie_frame, audio found on the way is pushed to the audio stream
+// returns false once there is nothing left to decode
+bool decode_movie_frame()
+{
+	AVPacket packet;
+	int ret;
+	time_t decode_start, decode_end;
+
+	QueryPerformanceCounter((LARGE_INTEGER *)&decode_start);
+
+	while(true)
+	{
+		// a frame may still be pending from the previous packets, frame threading delays the output by one frame per thread
+		ret = avcodec_receive_frame(codec_ctx, movie_frame);
+
+		if (ret >= 0)
+		{
+			QueryPerformanceCounter((LARGE_INTEGER *)&decode_end);
+
+			movie_decoded_frames++;
+			movie_decode_time += decode_end - decode_start;
+
+			return true;
+		}
+
+		if (ret != AVERROR(EAGAIN))
+		{
+			ffnx_trace("%s: avcodec_receive_frame -> %d\n", __func__, ret);
+			return false;
+		}
+
+		if (av_read_frame(format_ctx, &packet) < 0)
+		{
+			if (video_draining) return false;
+
+			// end of file, flush the frames still held by the decoder
+			video_draining = true;
+			avcodec_send_packet(codec_ctx, NULL);
+
+			continue;
+		}
+
+		if(packet.stream_index == videostream)
+		{
+			ret = avcodec_send_packet(codec_ctx, &packet);
+
+			if (ret < 0)
+			{
+				ffnx_trace("%s: avcodec_send_packet -> %d\n", __func__, ret);
+				av_packet_unref(&packet);
+				return false;
+			}
+		}
+
+		if(packet.stream_index == audiostream)
+		{
+			ret = avcodec_send_packet(acodec_ctx, &packet);
+
+			if (ret < 0)
+			{
+				ffnx_trace("%s: avcodec_send_packet -> %d\n", __func__, ret);
+				av_packet_unref(&packet);
+				return false;
+			}
+
+			ret = avcodec_receive_frame(acodec_ctx, movie_frame);
+
+			if (ret == AVERROR_EOF)
+			{
+				ffnx_trace("%s: avcodec_receive_frame -> %d\n", __func__, ret);
+				av_packet_unref(&packet);
+				return false;
+			}
+
+			if (ret >= 0)
+			{
+				uint32_t bytesperpacket = audio_must_be_converted ? av_get_bytes_per_sample(AV_SAMPLE_FMT_FLT) : av_get_bytes_per_sample(acodec_ctx->sample_fmt);
+				uint32_t _size = bytesperpacket * movie_frame->nb_samples * acodec_ctx->ch_layout.nb_channels;
+
+				// Sometimes the captured frame may have no sound samples. Just skip and move forward
+				if (_size)
+				{
+					uint8_t *buffer;
+
+					av_samples_alloc(&buffer, movie_frame->linesize, acodec_ctx->ch_layout.nb_channels, movie_frame->nb_samples, (audio_must_be_converted ? AV_SAMPLE_FMT_FLT : acodec_ctx->sample_fmt), 0);
+					if (audio_must_be_converted) swr_convert(swr_ctx, &buffer, movie_frame->nb_samples, (const uint8_t**)movie_frame->extended_data, movie_frame->nb_samples);
+					else av_samples_copy(&buffer, movie_frame->extended_data, 0, 0, movie_frame->nb_samples, acodec_ctx->ch_layout.nb_channels, acodec_ctx->sample_fmt);
+
+					nxAudioEngine.pushStreamData(buffer, _size);
+
+					av_freep(&buffer);
+				}
+			}
+		}
+
+		av_packet_unref(&packet);
+	}
+}
+
+// pick the hardware pixel format when the decoder offers it, software decoding otherwise (e.g. unsupported profile)
+AVPixelFormat get_hw_format(AVCodecContext *ctx, const AVPixelFormat *formats)
+{
+	const AVPixelFormat *format;
+
+	for (format = formats; *format != AV_PIX_FMT_NONE; format++)
+	{
+		if (*format == hw_pix_fmt)
+		{
+			hw_decoding = true;
+			return *format;
+		}
+	}
+
+	ffnx_warning("prepare_movie: %s decoding is not supported for this movie, falling back to software decoding\n", av_hwdevice_get_type_name(hw_device_type));
+
+	hw_decoding = false;
+
+	for (format = formats; *format != AV_PIX_FMT_NONE; format++)
+	{
+		if (!(av_pix_fmt_desc_get(*format)->flags & AV_PIX_FMT_FLAG_HWACCEL)) return *format;
+	}
+
+	return AV_PIX_FMT_NONE;
+}
+
+// attach the hardware device selected by ffmpeg_video_hwaccel to codec_ctx, returns false if none is usable
+bool create_hw_device()
+{
+	AVHWDeviceType wanted_type = AV_HWDEVICE_TYPE_NONE;
+
+	if (ffmpeg_video_hwaccel == "none") return false;
+
+	if (ffmpeg_video_hwaccel != "auto")
+	{
+		wanted_type = av_hwdevice_find_type_by_name(ffmpeg_video_hwaccel.c_str());
+
+		if (wanted_type == AV_HWDEVICE_TYPE_NONE)
+		{
+			ffnx_warning("prepare_movie: unknown hardware decoder %s, using software decoding\n", ffmpeg_video_hwaccel.c_str());
+			return false;
+		}
+	}
+
+	for (int i = 0;; i++)
+	{
+		const AVCodecHWConfig *config = avcodec_get_hw_config(codec, i);
+
+		if (!config) break;
+
+		if (!(config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX)) continue;
+
+		if (wanted_type != AV_HWDEVICE_TYPE_NONE && config->device_type != wanted_type) continue;
+
+		if (av_hwdevice_ctx_create(&hw_device_ctx, config->device_type, NULL, NULL, 0) < 0)
+		{
+			if (trace_movies || trace_all) ffnx_trace("prepare_movie: %s device is not available\n", av_hwdevice_get_type_name(config->device_type));
+			continue;
+		}
+
+		hw_device_type = config->device_type;
+		hw_pix_fmt = config->pix_fmt;
+
+		codec_ctx->hw_device_ctx = av_buffer_ref(hw_device_ctx);
+		codec_ctx->get_format = get_hw_format;
+
+		return true;
+	}
+
+	if (trace_movies || trace_all) ffnx_trace("prepare_movie: no hardware decoder available for %s, using software decoding\n", codec->name);
+
+	return false;
+}
+
+void release_hw_device()
+{
+	if (hw_transfer_frame) av_frame_free(&hw_transfer_frame);
+	if (hw_device_ctx) av_buffer_unref(&hw_device_ctx);
+
+	hw_device_type = AV_HWDEVICE_TYPE_NONE;
+	hw_pix_fmt = AV_PIX_FMT_NONE;
+	hw_decoding = false;
+}
+
+// open the video codec on the hardware device if possible, software decoding with ffmpeg_video_threads threads otherwise
+bool open_video_codec()
+{
+	if (create_hw_device())
+	{
+		hw_decoding = true;
+
+		if (avcodec_open2(codec_ctx, codec, NULL) >= 0) return true;
+
+		ffnx_warning("prepare_movie: couldn't open video codec for %s decoding, falling back to software decoding\n", av_hwdevice_get_type_name(hw_device_type));
+
+		// start over from a clean context, a failed avcodec_open2 may leave it half initialized
+		avcodec_free_context(&codec_ctx);
+		release_hw_device();
+
+		codec_ctx = avcodec_alloc_context3(codec);
+		if (!codec_ctx) return false;
+		avcodec_parameters_to_context(codec_ctx, format_ctx->streams[videostream]->codecpar);
+	}
+
+	codec_ctx->thread_count = ffmpeg_video_threads;
+	codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+	return avcodec_open2(codec_ctx, codec, NULL) >= 0;
+}
+
+// hardware frames live in video memory, copy them back before converting them
+AVFrame *get_software_frame()
+{
+	if (movie_frame->format != hw_pix_fmt) return movie_frame;
+
+	if (!hw_transfer_frame) hw_transfer_frame = av_frame_alloc();
+	else av_frame_unref(hw_transfer_frame);
+
+	if (av_hwframe_transfer_data(hw_transfer_frame, movie_frame, 0) < 0)
+	{
+		ffnx_error("update_movie_sample: could not transfer the frame from the %s device\n", av_hwdevice_get_type_name(hw_device_type));
+		return nullptr;
+	}
+
+	return hw_transfer_frame;
+}
+
+void create_sws_context(AVPixelFormat src_format)
+{
+	if (trace_movies || trace_all)
+	{
+		ffnx_trace("prepare_movie: Video must be converted: IN codec_ctx->colorspace: %s\n", av_color_space_name(codec_ctx->colorspace));
+		ffnx_trace("prepare_movie: Video must be converted: IN pix_fmt: %s\n", av_pix_fmt_desc_get(src_format)->name);
+	}
+
+	sws_ctx = sws_getContext(
+		movie_width,
+		movie_height,
+		src_format,
+		movie_width,
+		movie_height,
+		targetpixelformat,
+		SWS_LANCZOS | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT,
+		NULL,
+		NULL,
+		NULL
+	);
+
+	// if we need a colorspace conversion, set it up here
+	// this would also be the place to set up color range conversion, if it worked -- which it doens't
+	if (!okcolorspace || yuvjfixneeded){
+		int *coefs_in;
+		int *coefs_out;
+		int srcRange, dstRange;
+		int brightness, contrast, saturation;
+		sws_getColorspaceDetails(sws_ctx, &coefs_in, &srcRange, &coefs_out, &dstRange, &brightness, &contrast, &saturation);
+
+		coefs_in = const_cast<int*>(sws_getCoefficients(codec_ctx->colorspace)); // const sucks
+		// use the same colorspace
+		if (okcolorspace){
+			coefs_out = coefs_in;
+		}
+		// convert
+		else {
+			coefs_out = const_cast<int*>(sws_getCoefficients(SWS_CS_ITU601)); // const sucks
+		}
+
+		// Surprisingly, these parameters don't appear to **do** anything in most cases.
+		// It appears that whether swscale does a range conversion is controlled by pixformat and range metadata.
+		// And it will do one regardless of whether you want it.
+		// Except, when the input format is YUVJ, these parameters can be used to **prevent** an un-asked-for PC->TV conversion
+		// (They are totally ignored with 10-bit input formats, however.)
+		// Gawd... swscale is a buggy mess...
+		if (yuvjfixneeded){
+			srcRange = fullrange_input ? 1 : 0; // use the input color range
+			dstRange = srcRange; // no conversion!
+		}
+
+		sws_setColorspaceDetails(sws_ctx, coefs_in, srcRange, coefs_out, dstRange, brightness, contrast, saturation);
+	}
+}
+
+// make sws_ctx match the format of the decoded frames, hardware decoders usually output NV12 whatever the stream format is
+void prepare_sws_context(AVPixelFormat format)
+{
+	// Don't check for !fullrange_input here because swscale won't always do color range conversions on request, so we can't rely on it and must instead do it ourselves in the shader
+	bool conversion_needed = format != targetpixelformat || !okcolorspace || yuvjfixneeded;
+
+	if (format == sws_src_format && (sws_ctx != nullptr) == conversion_needed) return;
+
+	if (sws_ctx) sws_freeContext(sws_ctx);
+	sws_ctx = nullptr;
+	sws_src_format = format;
+
+	if (conversion_needed) create_sws_context(format);
+}
+
+void movie_decoder_loop()
+{
+	uint32_t write = frame_ring_write.load();
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(frame_ring_mutex);
+
+			frame_ring_cv.wait(lock, [write] { return movie_decoder_stop || write - frame_ring_read.load() < frame_ring.size(); });
+
+			if (movie_decoder_stop) break;
+		}
+
+		if (!decode_movie_frame()) break;
+
+		AVFrame *decoded = get_software_frame();
+
+		if (!decoded) break;
+
+		prepare_sws_context((AVPixelFormat)decoded->format);
+
+		decoded_frame &frame = frame_ring[write % frame_ring.size()];
+
+		if (sws_ctx) sws_scale(sws_ctx, decoded->extended_data, decoded->linesize, 0, movie_height, frame.planes, frame.strides);
+		else av_image_copy(frame.planes, frame.strides, (const uint8_t **)decoded->extended_data, decoded->linesize, targetpixelformat, movie_width, movie_height);
+
+		frame_ring_write.store(++write);
+
+		{
+			std::lock_guard<std::mutex> lock(frame_ring_mutex);
+		}
+		frame_ring_cv.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(frame_ring_mutex);
+		movie_decoder_finished = true;
+	}
+	frame_ring_cv.notify_all();
+}
+
+// decode the movie on a separate thread, up to movie_decode_ahead_frames frames in advance
+void start_movie_decoder()
+{
+	frame_ring.resize(movie_decode_ahead_frames);
+
+	for (decoded_frame &frame : frame_ring)
+	{
+		if (av_image_alloc(frame.planes, frame.strides, movie_width, movie_height, targetpixelformat, 1) < 0)
+		{
+			ffnx_error("prepare_movie: could not allocate decoded frames, falling back to decoding on the game thread\n");
+
+			for (decoded_frame &allocated : frame_ring) av_freep(&allocated.planes[0]);
+			frame_ring.clear();
+
+			return;
+		}
+	}
+
+	frame_ring_read = 0;
+	frame_ring_write = 0;
+	movie_decoder_stop = false;
+	movie_decoder_finished = false;
+	movie_decoder_threaded = true;
+
+	movie_decoder = std::thread(movie_decoder_loop);
+}
+
+void stop_movie_decoder()
+{
+	if (!movie_decoder_threaded) return;
+
+	{
+		std::lock_guard<std::mutex> lock(frame_ring_mutex);
+		movie_decoder_stop = true;
+	}
+	frame_ring_cv.notify_all();
+
+	movie_decoder.join();
+
+	for (decoded_frame &frame : frame_ring) av_freep(&frame.planes[0]);
+	frame_ring.clear();
+
+	movie_decoder_threaded = false;
+}
+
 // clean up anything we have allocated
 void ffmpeg_release_movie_objects()
 {
 	uint32_t i;
 
+	stop_movie_decoder();
+
+	if (movie_texture_allocations > 0 && movie_frame_counter > 0 && movie_fps > 0.0 && (trace_movies || trace_all))
+	{
+		double seconds = movie_frame_counter / movie_fps;
+
+		ffnx_trace("release_movie_objects: %u texture allocations over %.1f seconds of movie (%.1f per second)\n", movie_texture_allocations, seconds, movie_texture_allocations / seconds);
+	}
+
+	movie_texture_allocations = 0;
+
+	if (movie_decoded_frames > 0 && movie_decode_time > 0 && (trace_movies || trace_all))
+	{
+		double milliseconds = movie_decode_time * 1000.0 / timer_freq;
+
+		ffnx_trace("release_movie_objects: decoded %u frames in %.1f ms (%.1f FPS) using %s decoding\n", movie_decoded_frames, milliseconds, movie_decoded_frames * 1000.0 / milliseconds, hw_decoding ? av_hwdevice_get_type_name(hw_device_type) : "software");
+	}
+
+	movie_decoded_frames = 0;
+	movie_decode_time = 0;
+
+	if (sws_planes[0]) av_freep(&sws_planes[0]);
+
+	bgr24_planes.clear();
+	bgr24_planes.shrink_to_fit();
+
+	if (timer_resolution_raised)
+	{
+		timeEndPeriod(1);
+		timer_resolution_raised = false;
+	}
+
 	if (movie_frame) av_frame_free(&movie_frame);
 	if (codec_ctx) avcodec_free_context(&codec_ctx);
+	release_hw_device();
 	if (acodec_ctx) avcodec_free_context(&acodec_ctx);
 	if (format_ctx) avformat_close_input(&format_ctx);
 	if (swr_ctx) {
@@ -105,6 +585,8 @@ void ffmpeg_release_movie_objects()
 		{
 			newRenderer.deleteTexture(video_buffer[i].yuv_textures[idx]);
 			video_buffer[i].yuv_textures[idx] = 0;
+			video_buffer[i].yuv_widths[idx] = 0;
+			video_buffer[i].yuv_heights[idx] = 0;
 		}
 	}
 
@@ -119,9 +601,6 @@ uint32_t ffmpeg_prepare_movie(const char *name, bool with_audio)
 	uint32_t i;
 	WAVEFORMATEX sound_format;
 	DSBUFFERDESC1 sbdesc;
-	bool okpixelformat = false;
-	bool okcolorspace = false;
-	bool yuvjfixneeded = false;
 	bool islogomovie = false;
 	bool isff8steammovie = false;
 	int lastbackslashindex = -1;
@@ -129,6 +608,17 @@ uint32_t ffmpeg_prepare_movie(const char *name, bool with_audio)
 	int scanoffset = 0;
 
 	movie_frames = 0;
+	movie_dropped_frames = 0;
+	movie_texture_allocations = 0;
+	movie_decoded_frames = 0;
+	movie_decode_time = 0;
+	okcolorspace = false;
+	yuvjfixneeded = false;
+	video_draining = false;
+
+	stop_movie_decoder();
+
+	if (sws_planes[0]) av_freep(&sws_planes[0]);
 
 	if(avformat_open_input(&format_ctx, name, NULL, NULL))
 	{
@@ -168,13 +658,19 @@ uint32_t ffmpeg_prepare_movie(const char *name, bool with_audio)
 	}
 	avcodec_parameters_to_context(codec_ctx, format_ctx->streams[videostream]->codecpar);
 
-	if(avcodec_open2(codec_ctx, codec, NULL) < 0)
+	if(!open_video_codec())
 	{
 		ffnx_error("prepare_movie: couldn't open video codec\n");
 		ffmpeg_release_movie_objects();
 		goto exit;
 	}
 
+	if (trace_movies || trace_all)
+	{
+		if (hw_device_ctx) ffnx_trace("prepare_movie: %s decoding\n", av_hwdevice_get_type_name(hw_device_type));
+		else ffnx_trace("prepare_movie: software decoding with %d threads\n", codec_ctx->thread_count);
+	}
+
 	if(audiostream >= 0)
 	{
 		acodec_ctx = avcodec_alloc_context3(acodec);
@@ -381,12 +877,9 @@ uint32_t ffmpeg_prepare_movie(const char *name, bool with_audio)
 		targetpixelformat = AV_PIX_FMT_YUV444P;
 	}
 
-	// will we need to convert the pixel format?
+	// will we need to convert the pixel format? see prepare_sws_context
 	// we're going to target YUV444 on the assumption that swscale does better subsampling than texture2D() in the shader
 	// Also, we generally shouldn't target a YUVJ format because that triggers a bunch of automatic, sometimes wrong, color range conversions
-	if (codec_ctx->pix_fmt == targetpixelformat){
-		okpixelformat = true;
-	}
 
 	switch(codec_ctx->color_primaries){
 		case AVCOL_PRI_BT709:
@@ -450,70 +943,16 @@ uint32_t ffmpeg_prepare_movie(const char *name, bool with_audio)
 
 	if(!movie_frame) movie_frame = av_frame_alloc();
 
-	if(sws_ctx) sws_freeContext(sws_ctx);
-
 	vbuffer_read = 0;
 	vbuffer_write = 0;
 
-	if(!okpixelformat || !okcolorspace || yuvjfixneeded)
-		// Don't check for !fullrange_input here because swscale won't always do color range conversions on request, so we can't rely on it and must instead do it ourselves in the shader
-	{
-		if (trace_movies || trace_all)
-		{
-			ffnx_trace("prepare_movie: Video must be converted: IN codec_ctx->colorspace: %s\n", av_color_space_name(codec_ctx->colorspace));
-			ffnx_trace("prepare_movie: Video must be converted: IN codec_ctx->pix_fmt: %s\n", av_pix_fmt_desc_get(codec_ctx->pix_fmt)->name);
-		}
-
-		sws_ctx = sws_getContext(
-			movie_width,
-			movie_height,
-			codec_ctx->pix_fmt,
-			movie_width,
-			movie_height,
-			targetpixelformat,
-			SWS_LANCZOS | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT,
-			NULL,
-			NULL,
-			NULL
-		);
-
-		// if we need a colorspace conversion, set it up here
-		// this would also be the place to set up color range conversion, if it worked -- which it doens't
-		if (!okcolorspace || yuvjfixneeded){
-			int *coefs_in;
-			int *coefs_out;
-			int srcRange, dstRange;
-			int brightness, contrast, saturation;
-			sws_getColorspaceDetails(sws_ctx, &coefs_in, &srcRange, &coefs_out, &dstRange, &brightness, &contrast, &saturation);
-
-			coefs_in = const_cast<int*>(sws_getCoefficients(codec_ctx->colorspace)); // const sucks
-			// use the same colorspace
-			if (okcolorspace){
-				coefs_out = coefs_in;
-			}
-			// convert
-			else {
-				coefs_out = const_cast<int*>(sws_getCoefficients(SWS_CS_ITU601)); // const sucks
-			}
-
-			// Surprisingly, these parameters don't appear to **do** anything in most cases.
-			// It appears that whether swscale does a range conversion is controlled by pixformat and range metadata.
-			// And it will do one regardless of whether you want it.
-			// Except, when the input format is YUVJ, these parameters can be used to **prevent** an un-asked-for PC->TV conversion
-			// (They are totally ignored with 10-bit input formats, however.)
-			// Gawd... swscale is a buggy mess...
-			if (yuvjfixneeded){
-				srcRange = fullrange_input ? 1 : 0; // use the input color range
-				dstRange = srcRange; // no conversion!
-			}
+	// the conversion depends on the movie, start from a fresh context
+	if(sws_ctx) sws_freeContext(sws_ctx);
+	sws_ctx = nullptr;
+	sws_src_format = AV_PIX_FMT_NONE;
 
-			sws_setColorspaceDetails(sws_ctx, coefs_in, srcRange, coefs_out, dstRange, brightness, contrast, saturation);
-		}
-
-	}
-	else {
-		sws_ctx = nullptr;
-	}
+	// the context is created again if the decoded frames turn out to be in another format
+	prepare_sws_context(codec_ctx->pix_fmt);
 
 	if(audiostream >= 0)
 	{
@@ -556,6 +995,11 @@ uint32_t ffmpeg_prepare_movie(const char *name, bool with_audio)
 		first_audio_packet = true;
 	}
 
+	// Sleep based frame pacing needs 1 ms timer precision
+	if (!timer_resolution_raised) timer_resolution_raised = timeBeginPeriod(1) == TIMERR_NOERROR;
+
+	if (enable_threaded_movie_decoding) start_movie_decoder();
+
 	exit:
 	movie_frame_counter = 0;
 
@@ -577,10 +1021,18 @@ void upload_yuv_texture(uint8_t **planes, int *strides, uint32_t num, uint32_t b
 
 	if (upload_width > tex_width) tex_width = upload_width;
 
-	if (video_buffer[buffer_index].yuv_textures[num])
-		newRenderer.deleteTexture(video_buffer[buffer_index].yuv_textures[num]);
+	struct video_frame &slot = video_buffer[buffer_index];
+
+	if (slot.yuv_textures[num] && slot.yuv_widths[num] == tex_width && slot.yuv_heights[num] == tex_height)
+	{
+		newRenderer.updateTexture(slot.yuv_textures[num], planes[num], tex_width, tex_height, upload_width, RendererTextureType::YUV);
+		return;
+	}
+
+	if (slot.yuv_textures[num])
+		newRenderer.deleteTexture(slot.yuv_textures[num]);
 
-	video_buffer[buffer_index].yuv_textures[num] = newRenderer.createTexture(
+	slot.yuv_textures[num] = newRenderer.createTexture(
 		planes[num],
 		tex_width,
 		tex_height,
@@ -588,12 +1040,86 @@ void upload_yuv_texture(uint8_t **planes, int *strides, uint32_t num, uint32_t b
 		RendererTextureType::YUV,
 		false
 	);
+	slot.yuv_widths[num] = tex_width;
+	slot.yuv_heights[num] = tex_height;
+
+	movie_texture_allocations++;
+}
+
+// split packed BGR24 pixels into R, G and B planes
+void deinterleave_bgr24(const uint8_t *src, uint8_t *red, uint8_t *green, uint8_t *blue, uint32_t pixels)
+{
+	uint32_t i = 0;
+
+#ifdef MOVIES_SSSE3
+	static const bool has_ssse3 = []() {
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+	}();
+
+	if (has_ssse3)
+	{
+		// shuffle.masks[plane][input] gathers the bytes of one plane from each of the three 16-byte inputs
+		struct shuffle_masks
+		{
+			__m128i masks[3][3];
+		};
+
+		static const shuffle_masks shuffle = []() {
+			shuffle_masks ret;
+
+			for (int plane = 0; plane < 3; plane++)
+			{
+				alignas(16) int8_t bytes[3][16];
+
+				memset(bytes, 0x80, sizeof(bytes));
+
+				for (int out = 0; out < 16; out++)
+				{
+					int offset = out * 3 + plane;
+
+					bytes[offset / 16][out] = offset % 16;
+				}
+
+				for (int input = 0; input < 3; input++) ret.masks[plane][input] = _mm_load_si128((const __m128i *)bytes[input]);
+			}
+
+			return ret;
+		}();
+
+		uint8_t *outputs[3] = { blue, green, red };
+
+		for (; i + 16 <= pixels; i += 16)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i *)(src + i * 3));
+			__m128i b = _mm_loadu_si128((const __m128i *)(src + i * 3 + 16));
+			__m128i c = _mm_loadu_si128((const __m128i *)(src + i * 3 + 32));
+
+			for (int plane = 0; plane < 3; plane++)
+			{
+				__m128i value = _mm_or_si128(
+					_mm_or_si128(_mm_shuffle_epi8(a, shuffle.masks[plane][0]), _mm_shuffle_epi8(b, shuffle.masks[plane][1])),
+					_mm_shuffle_epi8(c, shuffle.masks[plane][2])
+				);
+
+				_mm_storeu_si128((__m128i *)(outputs[plane] + i), value);
+			}
+		}
+	}
+#endif
+
+	for (; i < pixels; i++)
+	{
+		blue[i] = src[i * 3];
+		green[i] = src[i * 3 + 1];
+		red[i] = src[i * 3 + 2];
+	}
 }
 
 void buffer_yuv_frame(uint8_t **planes, int *strides)
 {
 	// Special case for BGR24. Make it planar RGB so we can pass it through the YUV plumbing
-	// Not very efficient, but it's not worth making everything else more complex for the sake of this one case.
 	if (targetpixelformat == AV_PIX_FMT_BGR24){
 		if (strides[0] % 3 != 0){
 			ffnx_error("buffer_yuv_frame: movie file claims to be bgr24, but stride isn't divisible by 3!\n");
@@ -603,40 +1129,17 @@ void buffer_yuv_frame(uint8_t **planes, int *strides)
 		}
 		const int planarstride = strides[0]/3;
 		int fakestrides[3] = {planarstride, planarstride, planarstride};
-		uint8_t* realbuffer = planes[0];
-		uint8_t* redbuffer = (uint8_t*)malloc(planarstride * movie_height * sizeof(uint8_t));
-		uint8_t* greenbuffer = (uint8_t*)malloc(planarstride * movie_height * sizeof(uint8_t));
-		uint8_t* bluebuffer = (uint8_t*)malloc(planarstride * movie_height * sizeof(uint8_t));
+		// rows are padded to a multiple of 3 bytes, so the whole frame can be split as a single run of pixels
+		const uint32_t planesize = planarstride * movie_height;
+		bgr24_planes.resize(planesize * 3);
+		uint8_t* redbuffer = bgr24_planes.data();
+		uint8_t* greenbuffer = redbuffer + planesize;
+		uint8_t* bluebuffer = greenbuffer + planesize;
 		uint8_t* fakeplanes[3] = {redbuffer, greenbuffer, bluebuffer};
-		int smallindex = 0;
-		int rgbindex = 0;
-		int maxindex = strides[0] * movie_height;
-		for (int i=0; i<maxindex; i++){
-			uint8_t nextbyte = realbuffer[i];
-			if (rgbindex == 0){
-				bluebuffer[smallindex] = nextbyte;
-			}
-			else if (rgbindex == 1){
-				greenbuffer[smallindex] = nextbyte;
-			}
-			else {
-				redbuffer[smallindex] = nextbyte;
-				smallindex++;
-			}
-			rgbindex++;
-			if (rgbindex > 2){
-				rgbindex = 0;
-			}
-		}
+		deinterleave_bgr24(planes[0], redbuffer, greenbuffer, bluebuffer, planesize);
 		upload_yuv_texture(fakeplanes, fakestrides, 0, vbuffer_write); // R as Y
 		upload_yuv_texture(fakeplanes, fakestrides, 1, vbuffer_write); // G as U
 		upload_yuv_texture(fakeplanes, fakestrides, 2, vbuffer_write); // B as V
-		free(redbuffer);
-		redbuffer = nullptr;
-		free(greenbuffer);
-		greenbuffer = nullptr;
-		free(bluebuffer);
-		bluebuffer = nullptr;
 	}
 	// normal case
 	else {
@@ -670,120 +1173,120 @@ void draw_yuv_frame(uint32_t buffer_index)
 	newRenderer.setGammaType(GAMMAFUNCTION_SRGB);
 }
 
-// display the next frame
-uint32_t ffmpeg_update_movie_sample(bool use_movie_fps)
+// upload a decoded frame and draw it
+void show_yuv_frame(uint8_t **planes, int *strides)
 {
-	AVPacket packet;
-	int ret;
-	time_t now;
-	DWORD DSStatus;
+	uint32_t buffer_index = vbuffer_write;
 
-	// no playable movie loaded, skip it
-	if(!format_ctx) return false;
+	buffer_yuv_frame(planes, strides);
 
-	// keep track of when we started playing this movie
-	if(movie_frame_counter == 0) QueryPerformanceCounter((LARGE_INTEGER *)&start_time);
+	// the movie is released when the frame could not be buffered
+	if(!format_ctx) return;
 
-	while((ret = av_read_frame(format_ctx, &packet)) >= 0)
-	{
-		if(packet.stream_index == videostream)
-		{
-			ret = avcodec_send_packet(codec_ctx, &packet);
+	draw_yuv_frame(buffer_index);
 
-			if (ret < 0)
-			{
-				ffnx_trace("%s: avcodec_send_packet -> %d\n", __func__, ret);
-				av_packet_unref(&packet);
-				break;
-			}
+	vbuffer_read = vbuffer_write;
+}
 
-			ret = avcodec_receive_frame(codec_ctx, movie_frame);
+// take the next frame out of the decoder thread ring, returns false once the movie has ended
+bool show_decoded_frame(bool use_movie_fps)
+{
+	time_t now;
+	uint32_t read = frame_ring_read.load();
 
-			if (ret == AVERROR_EOF)
-			{
-				ffnx_trace("%s: avcodec_receive_frame -> %d\n", __func__, ret);
-				av_packet_unref(&packet);
-				break;
-			}
+	{
+		std::unique_lock<std::mutex> lock(frame_ring_mutex);
 
-			if (ret >= 0)
-			{
-				QueryPerformanceCounter((LARGE_INTEGER *)&now);
+		frame_ring_cv.wait(lock, [read] { return frame_ring_write.load() != read || movie_decoder_finished; });
+	}
 
-				if(sws_ctx)
-				{
-					AVFrame* frame = av_frame_alloc();
-					frame->width = movie_width;
-					frame->height = movie_height;
-					frame->format = targetpixelformat;
+	if(frame_ring_write.load() == read) return false;
 
-					av_image_alloc(frame->data, frame->linesize, frame->width, frame->height, AVPixelFormat(frame->format), 1);
+	// more than one frame late, skip the frames which are already decoded to catch up
+	if(use_movie_fps && movie_frame_counter > 0)
+	{
+		QueryPerformanceCounter((LARGE_INTEGER *)&now);
 
-					sws_scale(sws_ctx, movie_frame->extended_data, movie_frame->linesize, 0, frame->height, frame->data, frame->linesize);
-					buffer_yuv_frame(frame->data, frame->linesize);
+		while(LAG > 1000.0 / movie_fps && frame_ring_write.load() - read > 1)
+		{
+			read++;
+			movie_frame_counter++;
+			movie_dropped_frames++;
+		}
+	}
 
-					av_freep(&frame->data[0]);
-					av_frame_free(&frame);
-				}
-				else buffer_yuv_frame(movie_frame->extended_data, movie_frame->linesize);
+	decoded_frame &frame = frame_ring[read % frame_ring.size()];
 
-				if(vbuffer_write == vbuffer_read)
-				{
-					draw_yuv_frame(vbuffer_read);
+	show_yuv_frame(frame.planes, frame.strides);
 
-					vbuffer_read = (vbuffer_read + 1) % VIDEO_BUFFER_SIZE;
+	if(!format_ctx) return false;
 
-					av_packet_unref(&packet);
+	frame_ring_read.store(read + 1);
 
-					break;
-				}
-			}
-		}
+	{
+		std::lock_guard<std::mutex> lock(frame_ring_mutex);
+	}
+	frame_ring_cv.notify_all();
 
-		if(packet.stream_index == audiostream)
-		{
-			QueryPerformanceCounter((LARGE_INTEGER *)&now);
+	return true;
+}
 
-			ret = avcodec_send_packet(acodec_ctx, &packet);
+// wait for the next frame, sleeping while it is not due yet
+void wait_for_next_movie_frame()
+{
+	time_t now;
+	double lag;
 
-			if (ret < 0)
-			{
-				ffnx_trace("%s: avcodec_send_packet -> %d\n", __func__, ret);
-				av_packet_unref(&packet);
-				break;
-			}
+	do
+	{
+		QueryPerformanceCounter((LARGE_INTEGER *)&now);
 
-			ret = avcodec_receive_frame(acodec_ctx, movie_frame);
+		lag = LAG;
 
-			if (ret == AVERROR_EOF)
-			{
-				ffnx_trace("%s: avcodec_receive_frame -> %d\n", __func__, ret);
-				av_packet_unref(&packet);
-				break;
-			}
+		// Sleep cannot be more precise than 1 ms, spin for the last one
+		if(lag < -1.0) Sleep(DWORD(-lag) - 1);
+	} while(lag < 0.0);
+}
 
-			if (ret >= 0)
-			{
-				uint32_t bytesperpacket = audio_must_be_converted ? av_get_bytes_per_sample(AV_SAMPLE_FMT_FLT) : av_get_bytes_per_sample(acodec_ctx->sample_fmt);
-				uint32_t _size = bytesperpacket * movie_frame->nb_samples * acodec_ctx->ch_layout.nb_channels;
+// display the next frame
+uint32_t ffmpeg_update_movie_sample(bool use_movie_fps)
+{
+	bool has_frame;
 
-				// Sometimes the captured frame may have no sound samples. Just skip and move forward
-				if (_size)
-				{
-					uint8_t *buffer;
+	// no playable movie loaded, skip it
+	if(!format_ctx) return false;
 
-					av_samples_alloc(&buffer, movie_frame->linesize, acodec_ctx->ch_layout.nb_channels, movie_frame->nb_samples, (audio_must_be_converted ? AV_SAMPLE_FMT_FLT : acodec_ctx->sample_fmt), 0);
-					if (audio_must_be_converted) swr_convert(swr_ctx, &buffer, movie_frame->nb_samples, (const uint8_t**)movie_frame->extended_data, movie_frame->nb_samples);
-					else av_samples_copy(&buffer, movie_frame->extended_data, 0, 0, movie_frame->nb_samples, acodec_ctx->ch_layout.nb_channels, acodec_ctx->sample_fmt);
+	// keep track of when we started playing this movie
+	if(movie_frame_counter == 0) QueryPerformanceCounter((LARGE_INTEGER *)&start_time);
 
-					nxAudioEngine.pushStreamData(buffer, _size);
+	if(movie_decoder_threaded) has_frame = show_decoded_frame(use_movie_fps);
+	else
+	{
+		has_frame = decode_movie_frame();
 
-					av_freep(&buffer);
+		AVFrame *decoded = has_frame ? get_software_frame() : nullptr;
+
+		if(decoded)
+		{
+			prepare_sws_context((AVPixelFormat)decoded->format);
+
+			if(sws_ctx)
+			{
+				if(!sws_planes[0] && av_image_alloc(sws_planes, sws_strides, movie_width, movie_height, targetpixelformat, 1) < 0)
+				{
+					ffnx_error("update_movie_sample: could not allocate the converted frame\n");
+					sws_planes[0] = nullptr;
+				}
+				else
+				{
+					sws_scale(sws_ctx, decoded->extended_data, decoded->linesize, 0, movie_height, sws_planes, sws_strides);
+					show_yuv_frame(sws_planes, sws_strides);
 				}
 			}
+			else show_yuv_frame(decoded->extended_data, decoded->linesize);
 		}
 
-		av_packet_unref(&packet);
+		has_frame = decoded && format_ctx != nullptr;
 	}
 
 	if (first_audio_packet)
@@ -798,28 +1301,11 @@ uint32_t ffmpeg_update_movie_sample(bool use_movie_fps)
 
 	movie_frame_counter++;
 
-	// could not read any more frames, exhaust video buffer then end movie
-	if(ret < 0)
-	{
-		if(vbuffer_write != vbuffer_read)
-		{
-			draw_yuv_frame(vbuffer_read);
-
-			vbuffer_read = (vbuffer_read + 1) % VIDEO_BUFFER_SIZE;
-		}
-
-		if(vbuffer_write == vbuffer_read) return false;
-	}
+	// could not read any more frames, end movie
+	if(!has_frame) return false;
 
 	// Pure movie playback has no frame limiter, although it is not always required. Use it only when necessary
-	if (use_movie_fps)
-	{
-		// wait for the next frame
-		do
-		{
-			QueryPerformanceCounter((LARGE_INTEGER *)&now);
-		} while(LAG < 0.0);
-	}
+	if (use_movie_fps) wait_for_next_movie_frame();
 
 	// keep going
 	return true;
@@ -828,13 +1314,26 @@ uint32_t ffmpeg_update_movie_sample(bool use_movie_fps)
 // draw the current frame, don't update anything
 void ffmpeg_draw_current_frame()
 {
-	draw_yuv_frame((vbuffer_read - 1) % VIDEO_BUFFER_SIZE);
+	draw_yuv_frame((vbuffer_read + VIDEO_BUFFER_SIZE - 1) % VIDEO_BUFFER_SIZE);
 }
 
 // loop back to the beginning of the movie
 void ffmpeg_loop()
 {
-	if(format_ctx) avformat_seek_file(format_ctx, -1, 0, 0, 0, 0);
+	if(format_ctx)
+	{
+		bool restart_decoder = movie_decoder_threaded;
+
+		stop_movie_decoder();
+
+		avformat_seek_file(format_ctx, -1, 0, 0, 0, 0);
+
+		// drop the frames still held by the decoder, this also leaves the draining state
+		avcodec_flush_buffers(codec_ctx);
+		video_draining = false;
+
+		if(restart_decoder) start_movie_decoder();
+	}
 }
 
 // get the current frame number
@@ -843,6 +1342,16 @@ uint32_t ffmpeg_get_movie_frame()
 	return movie_frame_counter;
 }
 
+uint32_t ffmpeg_get_decoded_frames_ahead()
+{
+	return movie_decoder_threaded ? frame_ring_write.load() - frame_ring_read.load() : 0;
+}
+
+uint32_t ffmpeg_get_dropped_frames()
+{
+	return movie_dropped_frames;
+}
+
 short ffmpeg_get_fps_ratio()
 {
 	return ceil(movie_fps / 15.0f);
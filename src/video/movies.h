@@ -35,6 +35,9 @@ uint32_t ffmpeg_update_movie_sample(bool use_movie_fps = true);
 void ffmpeg_draw_current_frame();
 void ffmpeg_loop();
 uint32_t ffmpeg_get_movie_frame();
+// Only meaningful when enable_threaded_movie_decoding = true
+uint32_t ffmpeg_get_decoded_frames_ahead();
+uint32_t ffmpeg_get_dropped_frames();
 
 short ffmpeg_get_fps_ratio();
 
@@ -31,6 +31,7 @@
 #include "ff8/engine.h"
 
 #include <queue>
+#include <algorithm>
 
 enum class display_type
 {
@@ -155,27 +156,67 @@ void begin_voice(byte window_id = 0)
 	}
 }
 
-bool play_voice(char* field_name, byte window_id, byte dialog_id, byte page_count)
+// Candidate names of the voice file for a dialog page, by order of preference: the window specific file first then the one shared by every window
+std::vector<std::string> get_voice_names(char* field_name, byte window_id, byte dialog_id, byte page_count)
 {
+	char page = page_count > 'z' - 'a' ? 'z' : 'a' + page_count;
 	char name[MAX_PATH];
-
-	char page = 'a' + page_count;
-	if (page > 'z') page = 'z';
+	std::vector<std::string> names;
 
 	sprintf(name, "%s/w%u_%u%c", field_name, window_id, dialog_id, page);
+	names.push_back(name);
 
-	if (!nxAudioEngine.canPlayVoice(name))
-		sprintf(name, "%s/%u%c", field_name, dialog_id, page);
+	sprintf(name, "%s/%u%c", field_name, dialog_id, page);
+	names.push_back(name);
 
-	if (!nxAudioEngine.canPlayVoice(name) && page_count == 0)
+	// The first page can also use the file of the whole dialog
+	if (page_count == 0)
 	{
 		sprintf(name, "%s/w%u_%u", field_name, window_id, dialog_id);
+		names.push_back(name);
 
-		if (!nxAudioEngine.canPlayVoice(name))
-			sprintf(name, "%s/%u", field_name, dialog_id);
+		sprintf(name, "%s/%u", field_name, dialog_id);
+		names.push_back(name);
 	}
 
-	return nxAudioEngine.playVoice(name, window_id, voice_volume, *common_externals.field_game_moment);
+	return names;
+}
+
+void prefetch_voice(char* field_name, byte window_id, byte dialog_id, byte page_count)
+{
+	if (!enable_voice_prefetch) return;
+
+	// Pages after 'z' all share its file, which is already playing
+	if (page_count > 'z' - 'a') return;
+
+	// Resolved by the prefetch thread, so missing files are not probed on the game thread
+	nxAudioEngine.prefetchVoice(get_voice_names(field_name, window_id, dialog_id, page_count), *common_externals.field_game_moment);
+}
+
+void prefetch_option(char* field_name, byte dialog_id, byte option_count)
+{
+	if (!enable_voice_prefetch) return;
+
+	char name[MAX_PATH];
+
+	sprintf(name, "%s/%u_%u", field_name, dialog_id, option_count);
+
+	nxAudioEngine.prefetchVoice({ name }, *common_externals.field_game_moment);
+}
+
+bool play_voice(char* field_name, byte window_id, byte dialog_id, byte page_count)
+{
+	std::vector<std::string> names = get_voice_names(field_name, window_id, dialog_id, page_count);
+
+	// The first candidate which exists, or the last one so that the miss is traced
+	auto name = std::find_if(names.begin(), names.end() - 1, [](const std::string& candidate) { return nxAudioEngine.canPlayVoice(candidate.c_str()); });
+
+	bool playing = nxAudioEngine.playVoice(name->c_str(), window_id, voice_volume, *common_externals.field_game_moment);
+
+	// The player will most likely go to the next page
+	prefetch_voice(field_name, window_id, dialog_id, page_count + 1);
+
+	return playing;
 }
 
 bool play_battle_dialogue_voice(short enemy_id, std::string tokenized_dialogue)
@@ -262,6 +303,10 @@ void play_option(char* field_name, byte window_id, byte dialog_id, byte option_c
 	sprintf(name, "%s/%u_%u", field_name, dialog_id, option_count);
 
 	nxAudioEngine.playVoice(name, window_id, voice_volume, *common_externals.field_game_moment);
+
+	// The player will most likely move to one of the neighbour options
+	if (option_count > 0) prefetch_option(field_name, dialog_id, option_count - 1);
+	if (option_count < UCHAR_MAX - 1) prefetch_option(field_name, dialog_id, option_count + 1);
 }
 
 void end_voice(byte window_id = 0, uint32_t time = 0)
@@ -410,6 +455,7 @@ int opcode_voice_message()
 	if (_is_dialog_opening)
 	{
 		begin_voice(window_id);
+		prefetch_voice(field_name, window_id, dialog_id, 0);
 	}
 	else if (_is_dialog_starting || _is_dialog_paging)
 	{
@@ -472,6 +518,7 @@ int opcode_voice_ask(int unk)
 	{
 		opcode_ask_current_option = UCHAR_MAX;
 		begin_voice(window_id);
+		prefetch_voice(field_name, window_id, dialog_id, 0);
 	}
 	else if (_is_dialog_starting || _is_dialog_paging)
 	{
@@ -512,6 +559,7 @@ int opcode_wm_message(uint8_t window_id, uint8_t dialog_id) {
 	{
 		begin_voice(window_id);
 		current_opcode_message_status[window_id].message_dialog_id = dialog_id;
+		prefetch_voice("_world", window_id, dialog_id, 0);
 	}
 	else if (_is_dialog_starting || _is_dialog_paging)
 	{
@@ -552,6 +600,8 @@ int opcode_wm_ask(uint8_t window_id, uint8_t dialog_id, uint8_t first_question_i
 	if (_is_dialog_opening)
 	{
 		begin_voice(window_id);
+		prefetch_voice("_world", window_id, dialog_id, 0);
+		prefetch_option("_world", dialog_id, first_question_id);
 	}
 	else if (_is_dialog_starting || _is_dialog_paging)
 	{
@@ -1183,6 +1233,7 @@ int ff8_show_dialog(int window_id, int state, int a3)
 			current_opcode_message_status[window_id].message_last_option = opcode_ask_current_option;
 			current_opcode_message_status[window_id].message_kind = message_kind;
 			current_opcode_message_status[window_id].field_name = field_name;
+			if (message_kind != message_kind::DRAWPOINT) prefetch_voice((char*)field_name.c_str(), window_id, dialog_id, 0);
 			if (message_kind == message_kind::DRAWPOINT) current_opcode_message_status[window_id].message_page_count = message_page_count;
 			if (message_kind == message_kind::MESSAGE)
 			{
@@ -0,0 +1,78 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#include "z_layers.h"
+
+void ZLayers::build(const float* triZ, uint32_t triCount)
+{
+	lookup.clear();
+	size.clear();
+	z.clear();
+	triLayer.resize(triCount);
+	tris.resize(triCount);
+
+	for (uint32_t tri = 0; tri < triCount; tri++)
+	{
+		// -0.0 and 0.0 compare equal but do not hash the same
+		float key = triZ[tri] == 0.0f ? 0.0f : triZ[tri];
+		auto [it, inserted] = lookup.try_emplace(key, uint32_t(size.size()));
+
+		if (inserted)
+		{
+			size.push_back(0);
+			z.push_back(triZ[tri]);
+		}
+
+		triLayer[tri] = it->second;
+		size[it->second]++;
+	}
+
+	start.resize(size.size());
+	next.resize(size.size());
+
+	for (uint32_t layer = 0, offset = 0; layer < size.size(); layer++)
+	{
+		start[layer] = next[layer] = offset;
+		offset += size[layer];
+	}
+
+	for (uint32_t tri = 0; tri < triCount; tri++) tris[next[triLayer[tri]]++] = tri;
+}
+
+uint32_t ZLayers::count() const
+{
+	return uint32_t(size.size());
+}
+
+float ZLayers::getZ(uint32_t layer) const
+{
+	return z[layer];
+}
+
+uint32_t ZLayers::getSize(uint32_t layer) const
+{
+	return size[layer];
+}
+
+const uint32_t* ZLayers::getTris(uint32_t layer) const
+{
+	return &tris[start[layer]];
+}
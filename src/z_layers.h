@@ -0,0 +1,49 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+// Groups the triangles of a draw call by their screen space Z in linear time.
+// Layers are numbered in order of first appearance, triangles keep their original order inside each layer.
+class ZLayers {
+private:
+	std::unordered_map<float, uint32_t> lookup;
+	std::vector<uint32_t> triLayer;
+	std::vector<uint32_t> tris;
+	std::vector<uint32_t> start;
+	std::vector<uint32_t> next;
+	std::vector<uint32_t> size;
+	std::vector<float> z;
+
+public:
+	// Buffers are kept across calls to avoid allocating on every draw
+	void build(const float* triZ, uint32_t triCount);
+
+	uint32_t count() const;
+	float getZ(uint32_t layer) const;
+	uint32_t getSize(uint32_t layer) const;
+	// Indexes of the triangles of the layer
+	const uint32_t* getTris(uint32_t layer) const;
+};
@@ -0,0 +1,172 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+// Self check of the audio sample conversion and of the MemoryStream ring buffer, run with ctest when built with -DTESTS=ON
+
+#include "audio/deinterleave/deinterleave.h"
+#include "audio/memorystream/memorystream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+using namespace SoLoud;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { failures++; if (failures <= 20) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } }
+
+// Compare the kernels with the plain loops they replaced, for every channel count and enough frames to cover the SIMD blocks and their tail
+static void check_deinterleave()
+{
+	srand(1);
+
+	for (uint32_t channels = 1; channels <= 8; channels++)
+	{
+		for (uint32_t samples = 0; samples < 70; samples++)
+		{
+			uint32_t stride = samples + 3;
+			std::vector<int16_t> s16(samples * channels);
+			std::vector<float> f32(samples * channels);
+
+			for (size_t i = 0; i < s16.size(); i++)
+			{
+				s16[i] = int16_t(rand() % 65536 - 32768);
+				f32[i] = s16[i] * 0.37f;
+			}
+
+			// Extremes are always part of the input
+			if (!s16.empty())
+			{
+				s16[0] = INT16_MIN;
+				s16[s16.size() - 1] = INT16_MAX;
+			}
+
+			// The padding past the samples must be left untouched
+			std::vector<float> out_s16(stride * channels, -9.0f), out_f32(stride * channels, -9.0f);
+
+			deinterleave_s16(out_s16.data(), s16.data(), samples, channels, stride);
+			deinterleave_f32(out_f32.data(), f32.data(), samples, channels, stride);
+
+			for (uint32_t k = 0; k < channels; k++)
+			{
+				for (uint32_t j = 0; j < stride; j++)
+				{
+					float got_s16 = out_s16[k * stride + j], got_f32 = out_f32[k * stride + j];
+
+					if (j < samples)
+					{
+						float expected = s16[j * channels + k] / (float)INT16_MAX;
+
+						CHECK(fabsf(got_s16 - expected) <= 1e-7f, "s16 channels=%u samples=%u [%u][%u]: %.9g != %.9g", channels, samples, k, j, got_s16, expected);
+						CHECK(got_f32 == f32[j * channels + k], "f32 channels=%u samples=%u [%u][%u]: %.9g != %.9g", channels, samples, k, j, got_f32, f32[j * channels + k]);
+					}
+					else
+					{
+						CHECK(got_s16 == -9.0f && got_f32 == -9.0f, "channels=%u samples=%u: wrote past the samples at [%u][%u]", channels, samples, k, j);
+					}
+				}
+			}
+		}
+	}
+}
+
+// Stream more samples than the ring holds, with reads that are not aligned to its length, so most of them wrap around its end
+static void check_memorystream(uint32_t channels, uint32_t pushFrames, uint32_t readFrames)
+{
+	const uint32_t rate = 100, total = rate * MEMORYSTREAM_BUFFER_SECONDS * channels * 6;
+
+	MemoryStream stream(float(rate), total, channels);
+	MemoryStreamInstance* instance = (MemoryStreamInstance*)stream.createInstance();
+	instance->mChannels = channels;
+
+	CHECK(stream.mBufferLength < total && stream.mBufferLength % channels == 0, "channels=%u: unexpected ring length %u", channels, stream.mBufferLength);
+
+	std::vector<float> chunk, out(readFrames * channels);
+	uint32_t written = 0, read = 0, wrapped = 0;
+
+	// Nothing is returned until enough samples have been pushed
+	CHECK(instance->getAudio(out.data(), readFrames, readFrames) == 0, "channels=%u: read from an empty stream", channels);
+
+	while (read + readFrames * channels <= total)
+	{
+		// Keep the ring as full as possible
+		while (written < total)
+		{
+			uint32_t count = std::min(pushFrames * channels, total - written);
+
+			if (stream.mBufferLength - (written - read) < count) break;
+
+			chunk.resize(count);
+			for (uint32_t i = 0; i < count; i++) chunk[i] = float(written + i);
+
+			CHECK(stream.push((uint8_t*)chunk.data(), count * sizeof(float)) == SO_NO_ERROR, "channels=%u: push of %u samples at %u failed", channels, count, written);
+			written += count;
+		}
+
+		if (read % stream.mBufferLength + readFrames * channels > stream.mBufferLength) wrapped++;
+
+		uint32_t got = instance->getAudio(out.data(), readFrames, readFrames);
+
+		CHECK(got == readFrames, "channels=%u: read of %u frames at %u returned %u", channels, readFrames, read, got);
+		if (got != readFrames) break;
+
+		for (uint32_t j = 0; j < readFrames; j++)
+		{
+			for (uint32_t k = 0; k < channels; k++)
+			{
+				float expected = float(read + j * channels + k);
+
+				CHECK(out[k * readFrames + j] == expected, "channels=%u: sample [%u][%u] at %u is %.0f instead of %.0f", channels, k, j, read, out[k * readFrames + j], expected);
+			}
+		}
+
+		read += readFrames * channels;
+	}
+
+	CHECK(wrapped > 0, "channels=%u: no read wrapped around the ring", channels);
+
+	delete instance;
+
+	// A push which does not fit keeps whole frames only
+	MemoryStream full(float(rate), total, channels);
+	std::vector<float> big(stream.mBufferLength + channels + 1);
+
+	CHECK(full.push((uint8_t*)big.data(), uint32_t(big.size() * sizeof(float))) == OUT_OF_MEMORY, "channels=%u: overflowing push was accepted", channels);
+	CHECK(full.mWriteOffset == full.mBufferLength, "channels=%u: overflowing push wrote %u samples in a ring of %u", channels, uint32_t(full.mWriteOffset), full.mBufferLength);
+}
+
+int main()
+{
+	check_deinterleave();
+
+	check_memorystream(1, 37, 64);
+	check_memorystream(2, 37, 64);
+	check_memorystream(2, 250, 333);
+	check_memorystream(6, 129, 70);
+
+	if (failures) printf("%d check(s) failed\n", failures);
+	else printf("All checks passed\n");
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,265 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+// Self check of the texture conversion kernels against the per-pixel loop convert_image_data used before them, run with ctest when built with -DTESTS=ON
+
+#include "image/convert.h"
+#include "macro.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { failures++; if (failures <= 20) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } }
+
+// Previous implementation, kept as it was apart from the logging
+static uint32_t reference_pal2bgra(uint32_t pixel, uint32_t *palette, uint32_t palette_offset, uint32_t color_key, uint32_t reference_alpha)
+{
+	if(color_key && pixel == 0) return 0;
+
+	else
+	{
+		uint32_t color = palette[palette_offset + pixel];
+		// FF7 uses a form of alpha keying to emulate PSX blending
+		if(BGRA_A(color) == 0xFE) color = (color & 0xFFFFFF) | reference_alpha;
+		return color;
+	}
+}
+
+static void reference_convert(const unsigned char *image_data, uint32_t *converted_image_data, uint32_t pixels, struct texture_format *tex_format, uint32_t invert_alpha, uint32_t color_key, uint32_t palette_offset, uint32_t reference_alpha)
+{
+	uint32_t o = 0, c = 0;
+
+	if(tex_format->bytesperpixel == 1)
+	{
+		for(uint32_t i = 0; i < pixels; i++)
+		{
+			if(image_data[o] > tex_format->palette_size) return;
+
+			converted_image_data[c++] = reference_pal2bgra(image_data[o++], tex_format->palette_data, palette_offset, color_key, reference_alpha);
+		}
+
+		return;
+	}
+
+	for(uint32_t i = 0; i < pixels; i++)
+	{
+		uint32_t pixel = 0;
+		uint32_t color = 0;
+
+		switch(tex_format->bytesperpixel)
+		{
+			// 16-bit RGB(A)
+			case 2:
+				pixel = *((uint16_t *)(&image_data[o]));
+				break;
+			// 24-bit RGB
+			case 3:
+				pixel = image_data[o] | image_data[o + 1] << 8 | image_data[o + 2] << 16;
+				break;
+			// 32-bit RGBA or RGBX
+			case 4:
+				pixel = *((uint32_t *)(&image_data[o]));
+				break;
+		}
+
+		o += tex_format->bytesperpixel;
+
+		// PSX style mask bit
+		if((color_key == 1 && (pixel & ~tex_format->alpha_mask) == 0) || (color_key == 3 && pixel == 0))
+		{
+			converted_image_data[c++] = 0;
+			continue;
+		}
+
+		// convert source data to 8 bits per channel
+		color = tex_format->blue_max > 0 ? ((((pixel & tex_format->blue_mask) >> tex_format->blue_shift) * 255) / tex_format->blue_max) : 0;
+		color |= (tex_format->green_max > 0 ? ((((pixel & tex_format->green_mask) >> tex_format->green_shift) * 255) / tex_format->green_max) : 0) << 8;
+		color |= (tex_format->red_max > 0 ? ((((pixel & tex_format->red_mask) >> tex_format->red_shift) * 255) / tex_format->red_max) : 0) << 16;
+
+		// special case to deal with poorly converted PSX images in FF7
+		if(invert_alpha && pixel != 0x8000) color |= (tex_format->alpha_max > 0 ? (255 - ((((pixel & tex_format->alpha_mask) >> tex_format->alpha_shift) * 255) / tex_format->alpha_max)) : 255) << 24;
+		else color |= (tex_format->alpha_max > 0 ? ((((pixel & tex_format->alpha_mask) >> tex_format->alpha_shift) * 255) / tex_format->alpha_max) : 255) << 24;
+
+		converted_image_data[c++] = color;
+	}
+}
+
+struct channel
+{
+	uint32_t bits, shift;
+};
+
+static struct texture_format make_format(uint32_t bytesperpixel, channel red, channel green, channel blue, channel alpha)
+{
+	struct texture_format format;
+
+	memset(&format, 0, sizeof(format));
+	format.bytesperpixel = bytesperpixel;
+	format.bitsperpixel = bytesperpixel * 8;
+
+	format.red_max = (1u << red.bits) - 1;
+	format.green_max = (1u << green.bits) - 1;
+	format.blue_max = (1u << blue.bits) - 1;
+	format.alpha_max = (uint32_t)((1ull << alpha.bits) - 1);
+
+	format.red_mask = format.red_max << red.shift;
+	format.green_mask = format.green_max << green.shift;
+	format.blue_mask = format.blue_max << blue.shift;
+	format.alpha_mask = format.alpha_max << alpha.shift;
+
+	format.red_shift = red.shift;
+	format.green_shift = green.shift;
+	format.blue_shift = blue.shift;
+	format.alpha_shift = alpha.shift;
+
+	return format;
+}
+
+static const uint32_t pixel_counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 63, 257, 1031 };
+
+// Random texels mixed with the values which take a special path: black, the PSX mask bit alone and the 0x8000 exception
+static std::vector<unsigned char> make_image(struct texture_format *format, uint32_t pixels)
+{
+	std::vector<unsigned char> image(pixels * format->bytesperpixel + 4);
+	uint32_t all = (uint32_t)((1ull << (format->bytesperpixel * 8)) - 1);
+
+	for(uint32_t c = 0; c < pixels; c++)
+	{
+		uint32_t pixel = (uint32_t(rand()) << 16 ^ uint32_t(rand())) & all;
+
+		switch(rand() % 8)
+		{
+			case 0: pixel = 0; break;
+			case 1: pixel = format->alpha_mask; break;
+			case 2: pixel = 0x8000 & all; break;
+		}
+
+		memcpy(&image[c * format->bytesperpixel], &pixel, format->bytesperpixel);
+	}
+
+	return image;
+}
+
+static void compare(const char *name, const unsigned char *image, uint32_t pixels, struct texture_format *format, uint32_t invert_alpha, uint32_t color_key, uint32_t palette_offset, uint32_t reference_alpha)
+{
+	// Both outputs start with the same garbage, so that texels left untouched after an error are compared too
+	std::vector<uint32_t> expected(pixels + 1, 0xDEADBEEF), got(pixels + 1, 0xDEADBEEF);
+
+	reference_convert(image, expected.data(), pixels, format, invert_alpha, color_key, palette_offset, reference_alpha);
+
+	if(format->bytesperpixel == 1) convert_paletted(image, got.data(), pixels, format, color_key, palette_offset, reference_alpha);
+	else convert_rgba(image, got.data(), pixels, format, invert_alpha, color_key);
+
+	for(uint32_t c = 0; c <= pixels; c++)
+	{
+		CHECK(got[c] == expected[c], "%s pixels=%u invert_alpha=%u color_key=%u: texel %u is %08X instead of %08X", name, pixels, invert_alpha, color_key, c, got[c], expected[c]);
+		if(got[c] != expected[c]) break;
+	}
+}
+
+static void check_rgba(const char *name, struct texture_format format)
+{
+	for(uint32_t pixels : pixel_counts)
+	{
+		std::vector<unsigned char> image = make_image(&format, pixels);
+
+		for(uint32_t invert_alpha = 0; invert_alpha <= 1; invert_alpha++)
+		{
+			for(uint32_t color_key : { 0u, 1u, 3u }) compare(name, image.data(), pixels, &format, invert_alpha, color_key, 0, 0);
+		}
+
+		// Offset the data so that the 32-bit loads are not aligned
+		std::vector<unsigned char> unaligned(image.size() + 1);
+		memcpy(unaligned.data() + 1, image.data(), image.size());
+		compare(name, unaligned.data() + 1, pixels, &format, 1, 1, 0, 0);
+	}
+}
+
+static void check_paletted(uint32_t palette_size)
+{
+	struct texture_format format;
+	std::vector<uint32_t> palette(512 + 257);
+
+	memset(&format, 0, sizeof(format));
+	format.bytesperpixel = 1;
+	format.bitsperpixel = 8;
+	format.use_palette = 1;
+	format.palette_size = palette_size;
+	format.palette_data = palette.data();
+
+	for(uint32_t i = 0; i < palette.size(); i++)
+	{
+		palette[i] = uint32_t(rand()) << 16 ^ uint32_t(rand());
+		// Entries using the FF7 alpha key
+		if(rand() % 4 == 0) palette[i] = (palette[i] & 0xFFFFFF) | 0xFE000000;
+	}
+
+	for(uint32_t pixels : pixel_counts)
+	{
+		std::vector<unsigned char> image(pixels);
+
+		// Only valid indexes, then indexes past the palette which abort the conversion
+		for(uint32_t invalid = 0; invalid <= 1; invalid++)
+		{
+			for(uint32_t c = 0; c < pixels; c++) image[c] = (unsigned char)(rand() % (invalid ? 256 : palette_size + 1));
+
+			for(uint32_t color_key = 0; color_key <= 1; color_key++)
+			{
+				for(uint32_t palette_offset : { 0u, 256u }) compare(palette_size < 256 ? "paletted" : "paletted 256", image.data(), pixels, &format, 0, color_key, palette_offset, 0x80000000);
+			}
+		}
+	}
+}
+
+int main()
+{
+	srand(1);
+
+	check_paletted(16);
+	check_paletted(255);
+	check_paletted(256);
+
+	// Formats handled by the BGRA copy, with and without SSE2
+	check_rgba("BGRA8888", make_format(4, { 8, 16 }, { 8, 8 }, { 8, 0 }, { 8, 24 }));
+	check_rgba("BGRX8888", make_format(4, { 8, 16 }, { 8, 8 }, { 8, 0 }, { 0, 0 }));
+	check_rgba("BGR888", make_format(3, { 8, 16 }, { 8, 8 }, { 8, 0 }, { 0, 0 }));
+
+	// Formats handled by the lookup tables
+	check_rgba("RGBA8888", make_format(4, { 8, 0 }, { 8, 8 }, { 8, 16 }, { 8, 24 }));
+	check_rgba("RGB888", make_format(3, { 8, 0 }, { 8, 8 }, { 8, 16 }, { 0, 0 }));
+	check_rgba("PSX 5551", make_format(2, { 5, 0 }, { 5, 5 }, { 5, 10 }, { 1, 15 }));
+	check_rgba("ARGB1555", make_format(2, { 5, 10 }, { 5, 5 }, { 5, 0 }, { 1, 15 }));
+	check_rgba("RGB565", make_format(2, { 5, 11 }, { 6, 5 }, { 5, 0 }, { 0, 0 }));
+	check_rgba("ARGB4444", make_format(2, { 4, 8 }, { 4, 4 }, { 4, 0 }, { 4, 12 }));
+
+	// Formats with channels too wide for the lookup tables
+	check_rgba("ARGB2101010", make_format(4, { 10, 20 }, { 10, 10 }, { 10, 0 }, { 2, 30 }));
+	check_rgba("RGB 16 bits", make_format(4, { 16, 0 }, { 8, 16 }, { 8, 24 }, { 0, 0 }));
+
+	if (failures) printf("%d check(s) failed\n", failures);
+	else printf("All checks passed\n");
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+// Benchmark of the config.toml lookups done by playSFX and loadSFX on each play, against the TOML node walk they replaced, run with ctest when built with -DTESTS=ON.
+// Both must pick the same effect ids, skip and loop flags.
+
+#include "audio/trackconfig/trackconfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { failures++; if (failures <= 20) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } }
+
+// Tracks configured in the generated config.toml, plays also ask for ids which are not configured
+#define SFX_TRACKS 800
+#define SFX_PLAYS 200000
+
+struct sfx_play
+{
+	std::string id;
+	bool skip;
+	bool loop;
+};
+
+static int getRandomInt(int min, int max)
+{
+	return min + rand() % (max - min + 1);
+}
+
+// Previous implementation: the parsed config.toml is walked on every play
+static sfx_play reference_play(toml::table& config, std::unordered_map<std::string, int>& sequentialIndexes, const char* name, int id, bool loop)
+{
+	int _curId = id;
+	bool skipPlay = false;
+	std::string _id(name);
+
+	auto node = config[name];
+	if (node)
+	{
+		toml::array *shuffleIds = node["shuffle"].as_array();
+		if (shuffleIds && !shuffleIds->empty() && shuffleIds->is_homogeneous(toml::node_type::integer))
+		{
+			auto _newId = shuffleIds->get(getRandomInt(0, shuffleIds->size() - 1));
+
+			_curId = _newId->value_or(id);
+			_id = std::to_string(_curId);
+		}
+
+		toml::array *sequentialIds = node["sequential"].as_array();
+		if (sequentialIds && !sequentialIds->empty() && sequentialIds->is_homogeneous(toml::node_type::integer))
+		{
+			if (sequentialIndexes.find(name) == sequentialIndexes.end() || sequentialIndexes[name] >= sequentialIds->size())
+				sequentialIndexes[name] = 0;
+
+			auto _newId = sequentialIds->get(sequentialIndexes[name]);
+
+			sequentialIndexes[name]++;
+
+			_curId = _newId->value_or(id);
+			_id = std::to_string(_curId);
+		}
+
+		toml::node *shouldSkip = node["skip"].as_boolean();
+		if (shouldSkip && shouldSkip->is_boolean()) {
+			skipPlay = shouldSkip->value_or(false);
+		}
+	}
+
+	// loadSFX
+	if (!skipPlay)
+	{
+		auto loadNode = config[_id];
+
+		if (loadNode)
+		{
+			int shouldLoop = loadNode["loop"].value_or(-1);
+
+			if (shouldLoop != -1) loop = shouldLoop;
+		}
+	}
+
+	return { _id, skipPlay, loop };
+}
+
+static const NxAudioEngineTrackConfig* getTrackConfig(const std::unordered_map<std::string, NxAudioEngineTrackConfig>& tracks, const std::string& name)
+{
+	auto it = tracks.find(name);
+
+	return it != tracks.end() ? &it->second : nullptr;
+}
+
+// Same steps as NxAudioEngine::playSFX and NxAudioEngine::loadSFX
+static sfx_play play(const std::unordered_map<std::string, NxAudioEngineTrackConfig>& tracks, std::unordered_map<std::string, int>& sequentialIndexes, const char* name, int id, bool loop)
+{
+	int _curId = id;
+	bool skipPlay = false;
+	std::string _id(name);
+
+	const NxAudioEngineTrackConfig* track = getTrackConfig(tracks, name);
+	if (track)
+	{
+		if (!track->shuffleIds.empty())
+		{
+			_curId = track->shuffleIds[getRandomInt(0, track->shuffleIds.size() - 1)];
+			_id = std::to_string(_curId);
+		}
+
+		if (!track->sequentialIds.empty())
+		{
+			int& sequentialIndex = sequentialIndexes[name];
+
+			if (sequentialIndex >= track->sequentialIds.size())
+				sequentialIndex = 0;
+
+			_curId = track->sequentialIds[sequentialIndex];
+
+			sequentialIndex++;
+
+			_id = std::to_string(_curId);
+		}
+
+		if (track->skip != -1) {
+			skipPlay = track->skip;
+		}
+	}
+
+	// loadSFX
+	if (!skipPlay)
+	{
+		const NxAudioEngineTrackConfig* loadTrack = getTrackConfig(tracks, _id);
+
+		if (loadTrack && loadTrack->loop != -1) loop = loadTrack->loop;
+	}
+
+	return { _id, skipPlay, loop };
+}
+
+static double elapsed_nanoseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main()
+{
+	// A mix of the options found in the SFX config.toml of the mods
+	std::string source;
+
+	srand(1);
+
+	for (int id = 1; id <= SFX_TRACKS; id++)
+	{
+		source += "[" + std::to_string(id) + "]\n";
+
+		switch (id % 8)
+		{
+		case 0:
+			source += "shuffle = [ " + std::to_string(getRandomInt(1, 1000)) + ", " + std::to_string(getRandomInt(1, 1000)) + ", " + std::to_string(getRandomInt(1, 1000)) + " ]\n";
+			break;
+		case 1:
+			source += "sequential = [ " + std::to_string(getRandomInt(1, 1000)) + ", " + std::to_string(getRandomInt(1, 1000)) + " ]\n";
+			break;
+		case 2:
+			source += "skip = true\n";
+			break;
+		case 3:
+			source += "loop = false\n";
+			break;
+		default:
+			source += "loop = true\n";
+			break;
+		}
+	}
+
+	toml::table config = toml::parse(source);
+	std::unordered_map<std::string, NxAudioEngineTrackConfig> tracks;
+
+	compileTrackConfigs(tracks, config, true, false);
+
+	CHECK(tracks.size() == SFX_TRACKS, "%u tracks compiled instead of %u", unsigned(tracks.size()), SFX_TRACKS);
+
+	// Effects the game asks for, as it would call playSFX
+	std::vector<std::string> names(SFX_PLAYS);
+	std::vector<int> ids(SFX_PLAYS);
+	std::vector<bool> loops(SFX_PLAYS);
+
+	for (int i = 0; i < SFX_PLAYS; i++)
+	{
+		ids[i] = getRandomInt(1, 1000);
+		names[i] = std::to_string(ids[i]);
+		loops[i] = getRandomInt(0, 9) == 0;
+	}
+
+	std::vector<sfx_play> expected(SFX_PLAYS), result(SFX_PLAYS);
+	std::unordered_map<std::string, int> sequentialIndexes;
+
+	srand(2);
+	sequentialIndexes.clear();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < SFX_PLAYS; i++) expected[i] = reference_play(config, sequentialIndexes, names[i].c_str(), ids[i], loops[i]);
+	double reference_time = elapsed_nanoseconds(start) / SFX_PLAYS;
+
+	srand(2);
+	sequentialIndexes.clear();
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < SFX_PLAYS; i++) result[i] = play(tracks, sequentialIndexes, names[i].c_str(), ids[i], loops[i]);
+	double time = elapsed_nanoseconds(start) / SFX_PLAYS;
+
+	for (int i = 0; i < SFX_PLAYS; i++)
+	{
+		CHECK(result[i].id == expected[i].id && result[i].skip == expected[i].skip && result[i].loop == expected[i].loop,
+			"play %d of %s: got %s skip %d loop %d instead of %s skip %d loop %d", i, names[i].c_str(),
+			result[i].id.c_str(), result[i].skip, result[i].loop, expected[i].id.c_str(), expected[i].skip, expected[i].loop);
+	}
+
+	printf("%u tracks, %u plays: previous %.1f ns, compiled tables %.1f ns per play\n", SFX_TRACKS, SFX_PLAYS, reference_time, time);
+
+	if (failures) printf("%d check(s) failed\n", failures);
+	else printf("All checks passed\n");
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+/****************************************************************************/
+//    Copyright (C) 2009 Aali132                                            //
+//    Copyright (C) 2018 quantumpencil                                      //
+//    Copyright (C) 2018 Maxime Bacoux                                      //
+//    Copyright (C) 2020 myst6re                                            //
+//    Copyright (C) 2020 Chris Rizzitello                                   //
+//    Copyright (C) 2020 John Pritchard                                     //
+//    Copyright (C) 2025 Julian Xhokaxhiu                                   //
+//                                                                          //
+//    This file is part of FFNx                                             //
+//                                                                          //
+//    FFNx is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by  //
+//    the Free Software Foundation, either version 3 of the License         //
+//                                                                          //
+//    FFNx is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of        //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         //
+//    GNU General Public License for more details.                          //
+/****************************************************************************/
+
+// Benchmark of the Z layer grouping of gl_defer_sorted_draw against the quadratic search it replaced, run with ctest when built with -DTESTS=ON.
+// Both must produce the same layers, in the same order and with the triangles in the same order.
+
+#include "z_layers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { failures++; if (failures <= 20) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } }
+
+struct layers
+{
+	std::vector<float> z;
+	std::vector<std::vector<uint32_t>> tris;
+};
+
+// Previous implementation: each layer starts at the first triangle which is not in a layer yet, then the whole mesh is scanned twice for triangles with the same Z
+static void reference_build(const float* tri_z, uint32_t tri_count, struct layers& out)
+{
+	std::vector<bool> tri_deferred(tri_count, false);
+	uint32_t defer_index = 0;
+
+	out.z.clear();
+	out.tris.clear();
+
+	while(defer_index < tri_count)
+	{
+		float z = tri_z[defer_index];
+		uint32_t tri_num = 0;
+
+		for(uint32_t tri = 0; tri < tri_count; tri++) if(tri_z[tri] == z) tri_num++;
+
+		std::vector<uint32_t> tris;
+
+		tris.reserve(tri_num);
+
+		for(uint32_t tri = 0; tri < tri_count && tris.size() < tri_num; tri++)
+		{
+			if(tri_z[tri] == z)
+			{
+				tris.push_back(tri);
+				tri_deferred[tri] = true;
+			}
+		}
+
+		out.z.push_back(z);
+		out.tris.push_back(std::move(tris));
+
+		while(defer_index < tri_count && tri_deferred[defer_index]) defer_index++;
+	}
+}
+
+static double elapsed_microseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// distinct is the number of different Z values in the mesh, 0 for all different
+static void run(uint32_t tri_count, uint32_t distinct)
+{
+	std::vector<float> tri_z(tri_count);
+
+	for(uint32_t tri = 0; tri < tri_count; tri++)
+	{
+		tri_z[tri] = distinct ? float(rand() % distinct) / distinct : float(rand()) / RAND_MAX;
+		// -0.0 and 0.0 are the same layer
+		if(tri_z[tri] == 0.0f && (rand() & 1)) tri_z[tri] = -0.0f;
+	}
+
+	struct layers expected;
+	ZLayers z_layers;
+
+	reference_build(tri_z.data(), tri_count, expected);
+	z_layers.build(tri_z.data(), tri_count);
+
+	CHECK(z_layers.count() == expected.z.size(), "%u triangles: %u layers instead of %u", tri_count, z_layers.count(), uint32_t(expected.z.size()));
+
+	for(uint32_t layer = 0; layer < z_layers.count() && layer < expected.z.size(); layer++)
+	{
+		bool same = z_layers.getZ(layer) == expected.z[layer] && z_layers.getSize(layer) == expected.tris[layer].size();
+
+		for(uint32_t i = 0; same && i < z_layers.getSize(layer); i++) same = z_layers.getTris(layer)[i] == expected.tris[layer][i];
+
+		CHECK(same, "%u triangles: layer %u differs", tri_count, layer);
+	}
+
+	// Enough runs for a stable timing, without spending seconds on the quadratic version
+	uint32_t reference_runs = uint32_t(std::max<uint64_t>(1, 20000000ull / (uint64_t(tri_count) * expected.z.size())));
+	uint32_t runs = std::max<uint32_t>(1, 2000000 / tri_count);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < reference_runs; i++) reference_build(tri_z.data(), tri_count, expected);
+	double reference_time = elapsed_microseconds(start) / reference_runs;
+
+	start = std::chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < runs; i++) z_layers.build(tri_z.data(), tri_count);
+	double time = elapsed_microseconds(start) / runs;
+
+	printf("%6u triangles %6u layers: previous %12.1f us, ZLayers %9.1f us\n", tri_count, z_layers.count(), reference_time, time);
+}
+
+int main()
+{
+	srand(1);
+
+	for(uint32_t tri_count : { 100u, 1000u, 5000u, 20000u })
+	{
+		// A single layer, a few layers like most models, then one layer per triangle
+		run(tri_count, 1);
+		run(tri_count, 16);
+		run(tri_count, 0);
+	}
+
+	if (failures) printf("%d check(s) failed\n", failures);
+	else printf("All checks passed\n");
+
+	return failures ? 1 : 0;
+}